@@ -0,0 +1,143 @@
+#include "analyzer.h"
+
+#include "samples.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+const size_t CHUNK_FRAMES = 1024;
+
+size_t next_power_of_two(size_t x) {
+    size_t result = 1;
+    while (result < x) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}
+
+Analyzer::Analyzer(const SDL_AudioSpec &spec, size_t frame_size, size_t hop_size)
+  : spec(spec),
+    frame_size(frame_size),
+    hop_size(hop_size),
+    bytes_per_frame(spec.channels * get_sample_size(spec.format)),
+    samples(next_power_of_two(std::max<size_t>(4 * frame_size, static_cast<size_t>(spec.freq)))),
+    blocks(256),
+    converted(CHUNK_FRAMES * spec.channels),
+    mono(CHUNK_FRAMES),
+    pushed(0),
+    output_latency(0.0f),
+    latency(0.0f),
+    max_latency(0.0f),
+    quit(false)
+{
+    if (!is_supported_format(spec.format)) {
+        throw std::runtime_error("Unsupported audio format for analysis");
+    }
+    for (auto &feature : features) {
+        feature.store(0.0f);
+    }
+    worker = std::thread(&Analyzer::run, this);
+}
+
+Analyzer::~Analyzer() {
+    quit.store(true);
+    condition.notify_one();
+    worker.join();
+}
+
+void Analyzer::push(const Uint8 *data, int len) {
+    const size_t frames = static_cast<size_t>(len) / bytes_per_frame;
+    for (size_t done = 0; done < frames; done += CHUNK_FRAMES) {
+        const size_t count = std::min(CHUNK_FRAMES, frames - done);
+        convert_to_float(data + done * bytes_per_frame, spec.format, count * spec.channels, converted.data());
+        write(converted.data(), count);
+    }
+    finish_block();
+}
+
+void Analyzer::push(const float *samples, size_t frames) {
+    for (size_t done = 0; done < frames; done += CHUNK_FRAMES) {
+        const size_t count = std::min(CHUNK_FRAMES, frames - done);
+        write(samples + done * spec.channels, count);
+    }
+    finish_block();
+}
+
+void Analyzer::write(const float *samples, size_t frames) {
+    convert_to_mono(samples, spec.channels, frames, mono.data());
+    pushed += this->samples.write(mono.data(), frames);
+}
+
+void Analyzer::finish_block() {
+    const Block block = { pushed, SDL_GetPerformanceCounter() };
+    blocks.write(&block, 1);
+    condition.notify_one();
+}
+
+const std::atomic<float> &Analyzer::get_feature(FeatureExtractor::Feature feature) const {
+    return features[feature];
+}
+
+void Analyzer::run() {
+    FeatureExtractor extractor(spec.freq, frame_size);
+    std::vector<float> frame(frame_size, 0.0f);
+    Uint64 consumed = 0;
+    Block pending = { 0, 0 };
+    bool has_pending = false;
+    const double ms_per_tick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    while (!quit.load()) {
+        if (samples.available() < hop_size) {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+
+        std::copy(frame.begin() + hop_size, frame.end(), frame.begin());
+        samples.read(frame.data() + frame_size - hop_size, hop_size);
+        consumed += hop_size;
+
+        const FeatureExtractor::Features values = extractor.process(frame.data());
+
+        // The newest sample in this frame is heard one output latency after it
+        // was handed to the device, so the features are held back until then.
+        Uint64 ticks = 0;
+        while (has_pending || blocks.read(&pending, 1) == 1) {
+            has_pending = true;
+            if (pending.end < consumed) {
+                has_pending = false;
+                continue;
+            }
+            ticks = pending.ticks;
+            break;
+        }
+        if (ticks != 0) {
+            const Uint64 played = ticks + static_cast<Uint64>(output_latency.load(std::memory_order_relaxed) / ms_per_tick);
+            std::unique_lock<std::mutex> lock(mutex);
+            for (Uint64 now = SDL_GetPerformanceCounter(); !quit.load() && now < played; now = SDL_GetPerformanceCounter()) {
+                const double wait = static_cast<double>(played - now) * ms_per_tick;
+                condition.wait_for(lock, std::chrono::microseconds(static_cast<long long>(wait * 1000.0) + 1));
+            }
+        }
+
+        for (size_t i = 0; i < values.size(); ++i) {
+            features[i].store(values[i], std::memory_order_release);
+        }
+
+        // Latency from the newest sample in this frame being played until its
+        // features are published.
+        if (ticks != 0) {
+            const Uint64 now = SDL_GetPerformanceCounter();
+            const float current = static_cast<float>((now - ticks) * ms_per_tick) - output_latency.load(std::memory_order_relaxed);
+            latency.store(std::max(current, 0.0f), std::memory_order_relaxed);
+            if (current > max_latency.load(std::memory_order_relaxed)) {
+                max_latency.store(current, std::memory_order_relaxed);
+            }
+        }
+    }
+}
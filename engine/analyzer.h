@@ -0,0 +1,65 @@
+#pragma once
+
+#include "featureextractor.h"
+#include "ringbuffer.h"
+
+#include <SDL.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Analyzer {
+public:
+    Analyzer(const SDL_AudioSpec &spec, size_t frame_size = 2048, size_t hop_size = 512);
+    ~Analyzer();
+
+    void push(const Uint8 *data, int len);
+    void push(const float *samples, size_t frames);
+
+    // The features are published when the samples they were extracted from
+    // are heard, which is the given milliseconds after they were pushed.
+    void set_output_latency(float latency) { output_latency.store(latency, std::memory_order_relaxed); }
+    const std::atomic<float> &get_feature(FeatureExtractor::Feature feature) const;
+    // The milliseconds from a sample being heard until its features are
+    // published, which is only above zero when the analysis can't keep up.
+    float get_latency() const { return latency.load(std::memory_order_relaxed); }
+    float get_max_latency() const { return max_latency.load(std::memory_order_relaxed); }
+
+    Analyzer(const Analyzer &) = delete;
+    Analyzer &operator = (const Analyzer &) = delete;
+private:
+    struct Block {
+        Uint64 end;
+        Uint64 ticks;
+    };
+
+    SDL_AudioSpec spec;
+    size_t frame_size;
+    size_t hop_size;
+    size_t bytes_per_frame;
+
+    RingBuffer<float> samples;
+    RingBuffer<Block> blocks;
+    std::vector<float> converted;
+    std::vector<float> mono;
+    Uint64 pushed;
+
+    void write(const float *samples, size_t frames);
+    void finish_block();
+
+    std::array<std::atomic<float>, FeatureExtractor::NUM_FEATURES> features;
+    std::atomic<float> output_latency;
+    std::atomic<float> latency;
+    std::atomic<float> max_latency;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> quit;
+    std::thread worker;
+
+    void run();
+};
@@ -1,5 +1,6 @@
 #include "audio.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -13,27 +14,50 @@ Audio::Lock::~Lock() {
     SDL_UnlockAudioDevice(id);
 }
 
-Audio::Audio(const SDL_AudioSpec &spec)
+Audio::Audio(const SDL_AudioSpec &spec, const LatencyPolicy &policy)
+  : id(0),
+    spec(spec),
+    policy(policy),
+    unstable_samples(0),
+    min_reachable_samples(policy.min_samples),
+    max_reachable_samples(policy.max_samples),
+    window_callbacks(0),
+    window_late_callbacks(0),
+    paused(true)
 {
     int num_audio_dev = SDL_GetNumAudioDevices(false);
     for (int i = 0; i < num_audio_dev; ++i) {
         std::cout << "Audio device " << i << ": " << SDL_GetAudioDeviceName(i, 0) << '\n';
     }
 
+    open(policy.min_samples);
+}
+
+Audio::~Audio() {
+    SDL_CloseAudioDevice(id);
+}
+
+void Audio::open(Uint16 samples) {
+    if (id != 0) {
+        SDL_CloseAudioDevice(id);
+    }
+
     SDL_AudioSpec internal_spec = spec;
+    internal_spec.samples = samples;
     internal_spec.callback = internal_callback;
     internal_spec.userdata = this;
-    id = SDL_OpenAudioDevice(nullptr, 0, &internal_spec, &this->spec, 0);
-    if (id < 0) {
+    id = SDL_OpenAudioDevice(nullptr, 0, &internal_spec, &spec, SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+    if (id == 0) {
         throw std::runtime_error("Can't open audio device");
     }
+    statistics.set_buffer_size(spec.freq, spec.samples);
+    statistics.restart();
+    window_callbacks = statistics.get_callbacks();
+    window_late_callbacks = statistics.get_late_callbacks();
+    SDL_PauseAudioDevice(id, paused);
 }
 
-Audio::~Audio() {
-    SDL_CloseAudioDevice(id);
-}
-
-void Audio::set_callback(std::function<void(Uint8 *, int)> callback) {
+void Audio::set_callback(std::function<int(Uint8 *, int)> callback) {
     this->callback = callback;
 }
 
@@ -41,7 +65,51 @@ const SDL_AudioSpec &Audio::get_spec() const {
     return spec;
 }
 
-void Audio::pause(bool wait) const {
+// The buffer just handed to SDL starts to play once the one in the device is
+// drained, so on average the audible sample lags the written ones by two
+// buffers.
+float Audio::get_latency() const {
+    return 2.0f * statistics.get_buffer_duration();
+}
+
+// Doubles the buffer when too many callbacks came late within the last window
+// and tries half the buffer after a clean window, but never a size that has
+// been too small before. When reopening the device doesn't change the size,
+// the driver won't go further in that direction, so it isn't tried again.
+bool Audio::adapt() {
+    const Uint32 callbacks = statistics.get_callbacks() - window_callbacks;
+    if (paused || callbacks < policy.window) {
+        return false;
+    }
+    const Uint32 late = statistics.get_late_callbacks() - window_late_callbacks;
+    window_callbacks += callbacks;
+    window_late_callbacks += late;
+
+    const float rate = static_cast<float>(late) / static_cast<float>(callbacks);
+    const Uint16 samples = spec.samples;
+    if (rate > policy.max_late_rate && samples < max_reachable_samples) {
+        unstable_samples = std::max(unstable_samples, samples);
+        open(static_cast<Uint16>(std::min<Uint32>(2 * samples, max_reachable_samples)));
+        if (spec.samples == samples) {
+            max_reachable_samples = samples;
+        }
+        return true;
+    }
+    if (late == 0 && samples / 2 >= min_reachable_samples && samples / 2 > unstable_samples) {
+        open(static_cast<Uint16>(samples / 2));
+        if (spec.samples == samples) {
+            min_reachable_samples = samples;
+        }
+        return true;
+    }
+    return false;
+}
+
+void Audio::pause(bool wait) {
+    if (paused && !wait) {
+        statistics.restart();
+    }
+    paused = wait;
     SDL_PauseAudioDevice(id, wait);
 }
 
@@ -51,7 +119,10 @@ Audio::Lock Audio::lock() const {
 
 void Audio::internal_callback(void *userdata, Uint8 *data, int len) {
     Audio *const self = static_cast<Audio *>(userdata);
+    const Uint64 start = SDL_GetPerformanceCounter();
+    int written = len;
     if (self->callback) {
-        self->callback(data, len);
+        written = self->callback(data, len);
     }
+    self->statistics.record(start, SDL_GetPerformanceCounter(), written < len);
 }
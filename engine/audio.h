@@ -1,9 +1,18 @@
 #pragma once
 
+#include "audiostatistics.h"
+
 #include <SDL.h>
 
 #include <functional>
 
+struct LatencyPolicy {
+    Uint16 min_samples = 256;
+    Uint16 max_samples = 8192;
+    Uint32 window = 1000;
+    float max_late_rate = 0.001f;
+};
+
 class Audio {
 public:
     class Lock {
@@ -19,17 +28,32 @@ public:
         SDL_AudioDeviceID id;
     };
 
-    explicit Audio(const SDL_AudioSpec &spec);
+    explicit Audio(const SDL_AudioSpec &spec, const LatencyPolicy &policy = LatencyPolicy());
     ~Audio();
 
-    void set_callback(std::function<void(Uint8 *, int)> callback);
+    void set_callback(std::function<int(Uint8 *, int)> callback);
     const SDL_AudioSpec &get_spec() const;
-    void pause(bool wait) const;
+    const AudioStatistics &get_statistics() const { return statistics; }
+    float get_latency() const;
+    bool adapt();
+    void pause(bool wait);
     Lock lock() const;
 private:
     SDL_AudioDeviceID id;
     SDL_AudioSpec spec;
-    std::function<void(Uint8 *, int)> callback;
+    LatencyPolicy policy;
+    Uint16 unstable_samples;
+    // The sizes beyond which the driver kept the size it had, as it may pin
+    // the buffer size despite SDL_AUDIO_ALLOW_SAMPLES_CHANGE.
+    Uint16 min_reachable_samples;
+    Uint16 max_reachable_samples;
+    Uint32 window_callbacks;
+    Uint32 window_late_callbacks;
+    bool paused;
+    AudioStatistics statistics;
+    std::function<int(Uint8 *, int)> callback;
+
+    void open(Uint16 samples);
 
     static void internal_callback(void *userdata, Uint8 *data, int len);
-};
\ No newline at end of file
+};
@@ -0,0 +1,105 @@
+#include "audiostatistics.h"
+
+AudioStatistics::Histogram::Histogram() {
+    reset();
+}
+
+void AudioStatistics::Histogram::add(Uint64 microseconds) {
+    size_t bucket = 0;
+    while (bucket + 1 < NUM_BUCKETS && (microseconds >> (bucket + 1)) != 0) {
+        ++bucket;
+    }
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioStatistics::Histogram::reset() {
+    for (auto &count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+AudioStatistics::AudioStatistics()
+  : ticks_per_second(SDL_GetPerformanceFrequency()),
+    freq(0),
+    buffer_size(0),
+    late_threshold(0),
+    previous_start(0),
+    previous_end_of_data(false),
+    callbacks(0),
+    late_callbacks(0),
+    end_of_data(0),
+    max_duration(0) { }
+
+void AudioStatistics::set_buffer_size(int freq, Uint16 samples) {
+    this->freq.store(freq, std::memory_order_relaxed);
+    buffer_size.store(samples, std::memory_order_relaxed);
+    // Callbacks arrive in bursts on some backends, so only an interval of one
+    // and a half buffers counts as the device running dry.
+    late_threshold.store(freq > 0 ? 3 * ticks_per_second * samples / (2 * static_cast<Uint64>(freq)) : 0, std::memory_order_relaxed);
+}
+
+float AudioStatistics::get_buffer_duration() const {
+    const int f = freq.load(std::memory_order_relaxed);
+    return f > 0 ? 1000.0f * static_cast<float>(get_buffer_size()) / static_cast<float>(f) : 0.0f;
+}
+
+void AudioStatistics::record(Uint64 start, Uint64 end, bool end_of_data) {
+    const Uint64 duration = (end - start) * 1000000 / ticks_per_second;
+    durations.add(duration);
+    if (duration > max_duration.load(std::memory_order_relaxed)) {
+        max_duration.store(static_cast<Uint32>(duration), std::memory_order_relaxed);
+    }
+    if (previous_start != 0) {
+        const Uint64 interval = start - previous_start;
+        intervals.add(interval * 1000000 / ticks_per_second);
+        if (interval > late_threshold.load(std::memory_order_relaxed)) {
+            late_callbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    previous_start = start;
+    if (end_of_data && !previous_end_of_data) {
+        this->end_of_data.fetch_add(1, std::memory_order_relaxed);
+    }
+    previous_end_of_data = end_of_data;
+    callbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Only call while no callback can run, i.e. with the device closed or paused.
+void AudioStatistics::restart() {
+    previous_start = 0;
+}
+
+void AudioStatistics::reset() {
+    previous_start = 0;
+    callbacks.store(0, std::memory_order_relaxed);
+    late_callbacks.store(0, std::memory_order_relaxed);
+    end_of_data.store(0, std::memory_order_relaxed);
+    max_duration.store(0, std::memory_order_relaxed);
+    durations.reset();
+    intervals.reset();
+}
+
+namespace {
+
+void dump_histogram(std::ostream &out, const char *name, const AudioStatistics::Histogram &histogram) {
+    out << "  " << name << ':';
+    for (size_t i = 0; i < AudioStatistics::Histogram::NUM_BUCKETS; ++i) {
+        const Uint32 count = histogram.get_count(i);
+        if (count != 0) {
+            out << ' ' << AudioStatistics::Histogram::get_bucket_start(i) << "us=" << count;
+        }
+    }
+    out << '\n';
+}
+
+}
+
+void AudioStatistics::dump(std::ostream &out) const {
+    out << "Audio: " << get_callbacks() << " callbacks, "
+        << get_late_callbacks() << " late, "
+        << get_end_of_data() << " at end of data, buffer "
+        << get_buffer_size() << " samples (" << get_buffer_duration() << " ms), max callback "
+        << get_max_duration() << " us\n";
+    dump_histogram(out, "callback", durations);
+    dump_histogram(out, "interval", intervals);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+class AudioStatistics {
+public:
+    class Histogram {
+    public:
+        static const size_t NUM_BUCKETS = 20;
+
+        Histogram();
+
+        void add(Uint64 microseconds);
+        void reset();
+
+        Uint32 get_count(size_t bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+        static Uint64 get_bucket_start(size_t bucket) { return bucket == 0 ? 0 : Uint64(1) << bucket; }
+
+    private:
+        std::array<std::atomic<Uint32>, NUM_BUCKETS> counts;
+    };
+
+    AudioStatistics();
+
+    void set_buffer_size(int freq, Uint16 samples);
+    // Counts the callbacks that ran out of data only when the data runs out,
+    // not for every callback after the end of the song.
+    void record(Uint64 start, Uint64 end, bool end_of_data);
+    void restart();
+    void reset();
+
+    Uint16 get_buffer_size() const { return buffer_size.load(std::memory_order_relaxed); }
+    float get_buffer_duration() const;
+    Uint32 get_callbacks() const { return callbacks.load(std::memory_order_relaxed); }
+    Uint32 get_late_callbacks() const { return late_callbacks.load(std::memory_order_relaxed); }
+    Uint32 get_end_of_data() const { return end_of_data.load(std::memory_order_relaxed); }
+    Uint32 get_max_duration() const { return max_duration.load(std::memory_order_relaxed); }
+    const Histogram &get_durations() const { return durations; }
+    const Histogram &get_intervals() const { return intervals; }
+
+    void dump(std::ostream &out) const;
+
+    AudioStatistics(const AudioStatistics &) = delete;
+    AudioStatistics &operator = (const AudioStatistics &) = delete;
+private:
+    Uint64 ticks_per_second;
+    std::atomic<int> freq;
+    std::atomic<Uint16> buffer_size;
+    std::atomic<Uint64> late_threshold;
+    Uint64 previous_start;
+    bool previous_end_of_data;
+
+    std::atomic<Uint32> callbacks;
+    std::atomic<Uint32> late_callbacks;
+    std::atomic<Uint32> end_of_data;
+    std::atomic<Uint32> max_duration;
+    Histogram durations;
+    Histogram intervals;
+};
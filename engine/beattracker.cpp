@@ -0,0 +1,193 @@
+#include "beattracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const float MIN_BPM = 60.0f;
+const float MAX_BPM = 200.0f;
+const float PREFERRED_BPM = 120.0f;
+const float TEMPO_SPREAD = 1.0f;
+const float TIGHTNESS = 100.0f;
+
+std::vector<float> onset_envelope(const std::vector<FeatureExtractor::Features> &frames) {
+    const size_t n = frames.size();
+    const size_t radius = 8;
+    std::vector<float> onset(n, 0.0f);
+    for (size_t i = 1; i < n; ++i) {
+        for (const auto band : { FeatureExtractor::BAND_LOW, FeatureExtractor::BAND_MID, FeatureExtractor::BAND_HIGH }) {
+            onset[i] += std::max(0.0f, frames[i][band] - frames[i - 1][band]);
+        }
+    }
+
+    std::vector<float> prefix(n + 1, 0.0f);
+    std::partial_sum(onset.begin(), onset.end(), prefix.begin() + 1);
+    std::vector<float> result(n);
+    for (size_t i = 0; i < n; ++i) {
+        const size_t begin = i > radius ? i - radius : 0;
+        const size_t end = std::min(n, i + radius + 1);
+        const float mean = (prefix[end] - prefix[begin]) / static_cast<float>(end - begin);
+        result[i] = std::max(0.0f, onset[i] - mean);
+    }
+
+    double sum = 0.0;
+    double sum2 = 0.0;
+    for (const float x : result) {
+        sum += x;
+        sum2 += x * x;
+    }
+    const double mean = sum / std::max<size_t>(1, n);
+    const double deviation = std::sqrt(std::max(0.0, sum2 / std::max<size_t>(1, n) - mean * mean));
+    if (deviation > 0.0) {
+        for (float &x : result) {
+            x = static_cast<float>(x / deviation);
+        }
+    }
+    return result;
+}
+
+std::vector<float> weighted_autocorrelation(const std::vector<float> &onset, size_t min_lag, size_t max_lag,
+                                            float frames_per_second, unsigned int num_threads)
+{
+    std::vector<float> result(max_lag + 1, 0.0f);
+    std::vector<std::thread> workers;
+    num_threads = std::max(1u, num_threads);
+    for (unsigned int w = 0; w < num_threads; ++w) {
+        workers.emplace_back([&, w] {
+            for (size_t lag = min_lag + w; lag <= max_lag; lag += num_threads) {
+                if (lag >= onset.size()) {
+                    continue;
+                }
+                double sum = 0.0;
+                for (size_t t = 0; t + lag < onset.size(); ++t) {
+                    sum += onset[t] * onset[t + lag];
+                }
+                const float bpm = 60.0f * frames_per_second / static_cast<float>(lag);
+                const float octaves = std::log2(bpm / PREFERRED_BPM) / TEMPO_SPREAD;
+                const float weight = std::exp(-0.5f * octaves * octaves);
+                result[lag] = weight * static_cast<float>(sum / static_cast<double>(onset.size() - lag));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return result;
+}
+
+std::vector<size_t> align_beats(const std::vector<float> &onset, float period) {
+    const size_t n = onset.size();
+    std::vector<float> score(n);
+    std::vector<std::ptrdiff_t> previous(n, -1);
+    const std::ptrdiff_t min_back = std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(std::round(period / 2.0f)));
+    const std::ptrdiff_t max_back = static_cast<std::ptrdiff_t>(std::round(2.0f * period));
+
+    for (std::ptrdiff_t t = 0; t < static_cast<std::ptrdiff_t>(n); ++t) {
+        float best = -INFINITY;
+        std::ptrdiff_t best_index = -1;
+        for (std::ptrdiff_t back = min_back; back <= max_back && back <= t; ++back) {
+            const float deviation = std::log(static_cast<float>(back) / period);
+            const float candidate = score[t - back] - TIGHTNESS * deviation * deviation;
+            if (candidate > best) {
+                best = candidate;
+                best_index = t - back;
+            }
+        }
+        if (best_index >= 0 && best > 0.0f) {
+            score[t] = onset[t] + best;
+            previous[t] = best_index;
+        } else {
+            score[t] = onset[t];
+        }
+    }
+
+    const size_t tail = std::min(n, static_cast<size_t>(std::ceil(period)));
+    std::ptrdiff_t last = static_cast<std::ptrdiff_t>(
+        std::max_element(score.end() - tail, score.end()) - score.begin());
+    std::vector<size_t> beats;
+    for (; last >= 0; last = previous[last]) {
+        beats.push_back(static_cast<size_t>(last));
+    }
+    std::reverse(beats.begin(), beats.end());
+    return beats;
+}
+
+}
+
+Beats track_beats(const std::vector<FeatureExtractor::Features> &frames, float frames_per_second,
+                  int beats_per_measure, unsigned int num_threads)
+{
+    const size_t min_lag = static_cast<size_t>(std::floor(60.0f * frames_per_second / MAX_BPM));
+    const size_t max_lag = static_cast<size_t>(std::ceil(60.0f * frames_per_second / MIN_BPM));
+    if (frames.size() < 4 * max_lag || beats_per_measure <= 0) {
+        throw std::runtime_error("Song is too short to track beats");
+    }
+
+    const std::vector<float> onset = onset_envelope(frames);
+
+    const std::vector<float> correlation = weighted_autocorrelation(onset, min_lag, max_lag, frames_per_second, num_threads);
+    size_t best_lag = min_lag;
+    for (size_t lag = min_lag; lag <= max_lag; ++lag) {
+        if (correlation[lag] > correlation[best_lag]) {
+            best_lag = lag;
+        }
+    }
+    float period = static_cast<float>(best_lag);
+    if (best_lag > min_lag && best_lag < max_lag) {
+        const float a = correlation[best_lag - 1];
+        const float b = correlation[best_lag];
+        const float c = correlation[best_lag + 1];
+        const float denominator = a - 2.0f * b + c;
+        if (denominator < 0.0f) {
+            period += 0.5f * (a - c) / denominator;
+        }
+    }
+    const float mean_correlation = std::accumulate(correlation.begin() + min_lag, correlation.end(), 0.0f)
+        / static_cast<float>(max_lag - min_lag + 1);
+
+    const std::vector<size_t> beats = align_beats(onset, period);
+
+    // Least squares fit of beat index against time gives tempo and phase.
+    const double count = static_cast<double>(beats.size());
+    double sum_k = 0.0, sum_t = 0.0, sum_kk = 0.0, sum_kt = 0.0;
+    for (size_t k = 0; k < beats.size(); ++k) {
+        const double t = static_cast<double>(beats[k]) / frames_per_second;
+        sum_k += k;
+        sum_t += t;
+        sum_kk += static_cast<double>(k) * k;
+        sum_kt += k * t;
+    }
+    const double slope = (count * sum_kt - sum_k * sum_t) / (count * sum_kk - sum_k * sum_k);
+    const double intercept = (sum_t - slope * sum_k) / count;
+
+    std::vector<float> strength(beats_per_measure, 0.0f);
+    float onset_at_beats = 0.0f;
+    for (size_t k = 0; k < beats.size(); ++k) {
+        strength[k % beats_per_measure] += frames[beats[k]][FeatureExtractor::BAND_LOW];
+        onset_at_beats += onset[beats[k]];
+    }
+    const size_t phase = std::max_element(strength.begin(), strength.end()) - strength.begin();
+    const float total_strength = std::accumulate(strength.begin(), strength.end(), 0.0f);
+    const float mean_onset = std::accumulate(onset.begin(), onset.end(), 0.0f) / static_cast<float>(onset.size());
+    const float beat_contrast = onset_at_beats / static_cast<float>(beats.size()) / std::max(mean_onset, 1e-6f) - 1.0f;
+
+    const double measure = slope * beats_per_measure;
+    const double downbeat = intercept + slope * static_cast<double>(phase);
+
+    Beats result;
+    result.bpm = static_cast<float>(60.0 / slope);
+    result.offset = static_cast<float>(1000.0 * (downbeat - std::floor(downbeat / measure) * measure));
+    result.beats_per_measure = beats_per_measure;
+    result.tempo_confidence = std::clamp(1.0f - mean_correlation / std::max(correlation[best_lag], 1e-6f), 0.0f, 1.0f);
+    result.beat_confidence = std::clamp(beat_contrast / (1.0f + beat_contrast), 0.0f, 1.0f);
+    result.downbeat_confidence = total_strength > 0.0f
+        ? std::clamp((strength[phase] / total_strength) * beats_per_measure - 1.0f, 0.0f, 1.0f) : 0.0f;
+    for (const size_t beat : beats) {
+        result.times.push_back(static_cast<float>(beat) / frames_per_second);
+    }
+    return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "featureextractor.h"
+
+#include <vector>
+
+struct Beats {
+    float bpm;
+    float offset;
+    int beats_per_measure;
+    float tempo_confidence;
+    float beat_confidence;
+    float downbeat_confidence;
+    std::vector<float> times;
+};
+
+Beats track_beats(const std::vector<FeatureExtractor::Features> &frames, float frames_per_second,
+                  int beats_per_measure, unsigned int num_threads);
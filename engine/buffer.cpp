@@ -1,13 +1,15 @@
 #include "buffer.h"
 
+#include "glstate.h"
+
 Buffer::Binding::Binding(GLenum target, const Buffer &buffer)
   : target(target)
 {
-    glBindBuffer(target, buffer.get_id());
+    GLState::get().bind_buffer(target, buffer.get_id());
 }
 
 Buffer::Binding::~Binding() {
-    glBindBuffer(target, 0);
+    GLState::get().release_buffer(target);
 }
 
 void Buffer::Binding::data(GLsizeiptr size, const void *data, GLenum usage) const {
@@ -23,13 +25,75 @@ void Buffer::Binding::vertex_attrib_pointer(const VertexArray::Binding &vao, GLu
 }
 
 Buffer::Buffer() {
-    glGenBuffers(1, &id);
+    if (GLState::get().has_direct_state_access()) {
+        glCreateBuffers(1, &id);
+    } else {
+        glGenBuffers(1, &id);
+    }
 }
 
 Buffer::~Buffer() {
+    GLState::get().forget_buffer(id);
     glDeleteBuffers(1, &id);
 }
 
 Buffer::Binding Buffer::bind(GLenum target) const {
     return Binding(target, *this);
 }
+
+void Buffer::bind_base(GLenum target, GLuint index) const {
+    GLState::get().bind_buffer_base(target, index, id);
+}
+
+void Buffer::data(GLsizeiptr size, const void *data, GLenum usage) const {
+    if (GLState::get().has_direct_state_access()) {
+        glNamedBufferData(id, size, data, usage);
+    } else {
+        bind(GL_COPY_WRITE_BUFFER).data(size, data, usage);
+    }
+}
+
+void Buffer::subdata(GLintptr offset, GLsizeiptr size, const void *data) const {
+    if (GLState::get().has_direct_state_access()) {
+        glNamedBufferSubData(id, offset, size, data);
+    } else {
+        bind(GL_COPY_WRITE_BUFFER).subdata(offset, size, data);
+    }
+}
+
+void Buffer::copy_subdata(const Buffer &source, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) const {
+    if (GLState::get().has_direct_state_access()) {
+        glCopyNamedBufferSubData(source.id, id, read_offset, write_offset, size);
+    } else {
+        auto read_binding = source.bind(GL_COPY_READ_BUFFER);
+        auto write_binding = bind(GL_COPY_WRITE_BUFFER);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, read_offset, write_offset, size);
+    }
+}
+
+void Buffer::storage(GLsizeiptr size, const void *data, GLbitfield flags) const {
+    if (GLState::get().has_direct_state_access()) {
+        glNamedBufferStorage(id, size, data, flags);
+    } else {
+        auto binding = bind(GL_COPY_WRITE_BUFFER);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, flags);
+    }
+}
+
+void *Buffer::map_range(GLintptr offset, GLsizeiptr length, GLbitfield access) const {
+    if (GLState::get().has_direct_state_access()) {
+        return glMapNamedBufferRange(id, offset, length, access);
+    } else {
+        auto binding = bind(GL_COPY_WRITE_BUFFER);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, length, access);
+    }
+}
+
+GLboolean Buffer::unmap() const {
+    if (GLState::get().has_direct_state_access()) {
+        return glUnmapNamedBuffer(id);
+    } else {
+        auto binding = bind(GL_COPY_WRITE_BUFFER);
+        return glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+}
@@ -6,6 +6,10 @@
 
 #include <optional>
 
+// The data of a buffer can be set through a binding to the target it's used
+// with, or on the buffer itself, which uses direct state access where it's
+// available and binds the buffer to GL_COPY_WRITE_BUFFER otherwise, so the
+// bindings to the other targets stay as they are.
 class Buffer {
 public:
     class Binding {
@@ -25,8 +29,19 @@ public:
     ~Buffer();
 
     Binding bind(GLenum target) const;
+    // Binds the buffer to a binding point of an indexed target, where it
+    // stays until another buffer is bound there.
+    void bind_base(GLenum target, GLuint index) const;
     GLuint get_id() const { return id; }
 
+    void data(GLsizeiptr size, const void *data, GLenum usage) const;
+    void subdata(GLintptr offset, GLsizeiptr size, const void *data) const;
+    // Copies size bytes from source on the GPU, without mapping either.
+    void copy_subdata(const Buffer &source, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size) const;
+    void storage(GLsizeiptr size, const void *data, GLbitfield flags) const;
+    void *map_range(GLintptr offset, GLsizeiptr length, GLbitfield access) const;
+    GLboolean unmap() const;
+
     Buffer(const Buffer &) = delete;
     Buffer &operator = (const Buffer &) = delete;
 private:
@@ -35,9 +35,9 @@ Destination::Destination(GLsizei width, GLsizei height)
     {
         auto binding = destination.bind(GL_TEXTURE0, GL_TEXTURE_2D);
         binding.image_2d(0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-        binding.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
+    destination.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    destination.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     {
         auto binding = depth_stencil.bind(GL_RENDERBUFFER);
         binding.storage(GL_DEPTH24_STENCIL8, width, height);
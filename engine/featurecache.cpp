@@ -0,0 +1,102 @@
+#include "featurecache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = { 'V', 'F', 'C', 'A' };
+const Uint32 VERSION = 1;
+
+struct Header {
+    char magic[4];
+    Uint32 version;
+    Uint64 hash;
+    Uint32 freq;
+    Uint32 hop_size;
+    Uint32 num_features;
+    Uint32 reserved;
+    Uint64 num_frames;
+};
+
+}
+
+std::string FeatureCache::get_filename(const std::string &wave_filename) {
+    return wave_filename + ".features";
+}
+
+void FeatureCache::write(const std::string &filename, Uint64 hash, int freq, size_t hop_size,
+                         const std::vector<FeatureExtractor::Features> &frames)
+{
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.hash = hash;
+    header.freq = static_cast<Uint32>(freq);
+    header.hop_size = static_cast<Uint32>(hop_size);
+    header.num_features = FeatureExtractor::NUM_FEATURES;
+    header.reserved = 0;
+    header.num_frames = frames.size();
+
+    std::ofstream output(filename, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("Can't write " + filename);
+    }
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<float> column(frames.size());
+    for (size_t feature = 0; feature < FeatureExtractor::NUM_FEATURES; ++feature) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            column[i] = frames[i][feature];
+        }
+        output.write(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(float));
+    }
+    if (!output) {
+        throw std::runtime_error("Can't write " + filename);
+    }
+}
+
+FeatureCache::FeatureCache(const std::string &filename, Uint64 hash)
+  : file(filename)
+{
+    if (file.get_size() < sizeof(Header)) {
+        throw std::runtime_error("Feature cache " + filename + " is truncated");
+    }
+    const Header *header = static_cast<const Header *>(file.get_data());
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION) {
+        throw std::runtime_error(filename + " is not a feature cache");
+    }
+    if (header->hash != hash) {
+        throw std::runtime_error("Feature cache " + filename + " belongs to a different song");
+    }
+    if (header->num_features != FeatureExtractor::NUM_FEATURES) {
+        throw std::runtime_error("Feature cache " + filename + " has different features");
+    }
+    num_frames = static_cast<size_t>(header->num_frames);
+    if (file.get_size() < sizeof(Header) + num_frames * header->num_features * sizeof(float)) {
+        throw std::runtime_error("Feature cache " + filename + " is truncated");
+    }
+    frames_per_second = static_cast<float>(header->freq) / static_cast<float>(header->hop_size);
+    data = reinterpret_cast<const float *>(header + 1);
+}
+
+const float *FeatureCache::get_feature(FeatureExtractor::Feature feature) const {
+    return data + feature * num_frames;
+}
+
+float FeatureCache::get_mean(FeatureExtractor::Feature feature, float begin, float end) const {
+    if (num_frames == 0) {
+        return 0.0f;
+    }
+    const float last = static_cast<float>(num_frames - 1);
+    const float first_frame = std::clamp(std::round(begin * frames_per_second), 0.0f, last);
+    const float last_frame = std::clamp(std::round(end * frames_per_second), first_frame, last);
+    const float *values = get_feature(feature);
+    float sum = 0.0f;
+    for (size_t i = static_cast<size_t>(first_frame); i <= static_cast<size_t>(last_frame); ++i) {
+        sum += values[i];
+    }
+    return sum / (last_frame - first_frame + 1.0f);
+}
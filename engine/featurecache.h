@@ -0,0 +1,30 @@
+#pragma once
+
+#include "featureextractor.h"
+#include "mappedfile.h"
+
+#include <SDL.h>
+
+#include <string>
+#include <vector>
+
+class FeatureCache {
+public:
+    static std::string get_filename(const std::string &wave_filename);
+    static void write(const std::string &filename, Uint64 hash, int freq, size_t hop_size,
+                      const std::vector<FeatureExtractor::Features> &frames);
+
+    FeatureCache(const std::string &filename, Uint64 hash);
+
+    float get_frames_per_second() const { return frames_per_second; }
+    size_t get_num_frames() const { return num_frames; }
+    const float *get_feature(FeatureExtractor::Feature feature) const;
+
+    float get_mean(FeatureExtractor::Feature feature, float begin, float end) const;
+
+private:
+    MappedFile file;
+    float frames_per_second;
+    size_t num_frames;
+    const float *data;
+};
@@ -0,0 +1,148 @@
+#include "featureextractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const float LOW_CUTOFF = 250.0f;
+const float MID_CUTOFF = 4000.0f;
+const float ONSET_COMPRESSION = 100.0f;
+
+}
+
+const char *FeatureExtractor::get_name(Feature feature) {
+    switch (feature) {
+    case BAND_LOW:
+        return "band.low";
+    case BAND_MID:
+        return "band.mid";
+    case BAND_HIGH:
+        return "band.high";
+    case RMS:
+        return "rms";
+    case ONSET:
+        return "onset";
+    default:
+        return "";
+    }
+}
+
+FeatureExtractor::FeatureExtractor(int freq, size_t size)
+  : fft(size),
+    window(size),
+    window_energy(0.0f),
+    real(size),
+    imag(size),
+    spectrum(size / 2 + 1),
+    previous(size / 2 + 1),
+    has_previous(false)
+{
+    const double pi = 3.14159265358979323846;
+    for (size_t i = 0; i < size; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * static_cast<double>(i) / static_cast<double>(size)));
+        window_energy += window[i] * window[i];
+    }
+    const float bin_width = static_cast<float>(freq) / static_cast<float>(size);
+    low_end = std::min(spectrum.size(), static_cast<size_t>(LOW_CUTOFF / bin_width) + 1);
+    mid_end = std::min(spectrum.size(), static_cast<size_t>(MID_CUTOFF / bin_width) + 1);
+}
+
+FeatureExtractor::Features FeatureExtractor::process(const float *frame) {
+    const size_t size = fft.get_size();
+    float energy = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        energy += frame[i] * frame[i];
+        real[i] = frame[i] * window[i];
+        imag[i] = 0.0f;
+    }
+    fft.transform(real.data(), imag.data());
+
+    for (size_t k = 0; k < spectrum.size(); ++k) {
+        spectrum[k] = real[k] * real[k] + imag[k] * imag[k];
+    }
+
+    // Parseval: the bands of a full-scale sine add up to its windowed RMS.
+    const float norm = 2.0f / (static_cast<float>(size) * window_energy);
+    float low = 0.0f;
+    float mid = 0.0f;
+    float high = 0.0f;
+    float flux = 0.0f;
+    for (size_t k = 1; k < spectrum.size(); ++k) {
+        if (k < low_end) {
+            low += spectrum[k];
+        } else if (k < mid_end) {
+            mid += spectrum[k];
+        } else {
+            high += spectrum[k];
+        }
+        const float magnitude = std::log1p(ONSET_COMPRESSION * std::sqrt(spectrum[k] * norm));
+        if (has_previous) {
+            flux += std::max(0.0f, magnitude - previous[k]);
+        }
+        previous[k] = magnitude;
+    }
+    has_previous = true;
+
+    Features features;
+    features[BAND_LOW] = std::sqrt(low * norm);
+    features[BAND_MID] = std::sqrt(mid * norm);
+    features[BAND_HIGH] = std::sqrt(high * norm);
+    features[RMS] = std::sqrt(energy / static_cast<float>(size));
+    features[ONSET] = flux / static_cast<float>(spectrum.size() - 1);
+    return features;
+}
+
+void FeatureExtractor::reset() {
+    has_previous = false;
+}
+
+namespace {
+
+// Frame i is centred on sample i * hop_size, zero padded at both ends.
+void extract_range(const std::vector<float> &samples, FeatureExtractor &extractor,
+                   size_t hop_size, size_t begin, size_t end,
+                   std::vector<FeatureExtractor::Features> &result)
+{
+    const size_t frame_size = extractor.get_size();
+    std::vector<float> frame(frame_size);
+    // The onset of the first frame depends on its predecessor.
+    const size_t warm_up = begin > 0 ? begin - 1 : begin;
+    for (size_t i = warm_up; i < end; ++i) {
+        const std::ptrdiff_t first = static_cast<std::ptrdiff_t>(i * hop_size) - static_cast<std::ptrdiff_t>(frame_size / 2);
+        for (size_t j = 0; j < frame_size; ++j) {
+            const std::ptrdiff_t index = first + static_cast<std::ptrdiff_t>(j);
+            frame[j] = index >= 0 && index < static_cast<std::ptrdiff_t>(samples.size()) ? samples[index] : 0.0f;
+        }
+        const FeatureExtractor::Features features = extractor.process(frame.data());
+        if (i >= begin) {
+            result[i] = features;
+        }
+    }
+}
+
+}
+
+std::vector<FeatureExtractor::Features> extract_features(const std::vector<float> &samples, int freq,
+                                                         size_t frame_size, size_t hop_size,
+                                                         unsigned int num_threads)
+{
+    const size_t num_frames = (samples.size() + hop_size - 1) / hop_size;
+    std::vector<FeatureExtractor::Features> result(num_frames);
+    num_threads = std::max(1u, num_threads);
+    const size_t chunk = (num_frames + num_threads - 1) / num_threads;
+
+    std::vector<std::thread> workers;
+    for (size_t begin = 0; begin < num_frames; begin += chunk) {
+        const size_t end = std::min(num_frames, begin + chunk);
+        workers.emplace_back([&samples, &result, freq, frame_size, hop_size, begin, end] {
+            FeatureExtractor extractor(freq, frame_size);
+            extract_range(samples, extractor, hop_size, begin, end, result);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "fft.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+class FeatureExtractor {
+public:
+    enum Feature {
+        BAND_LOW,
+        BAND_MID,
+        BAND_HIGH,
+        RMS,
+        ONSET,
+        NUM_FEATURES
+    };
+    using Features = std::array<float, NUM_FEATURES>;
+
+    static const char *get_name(Feature feature);
+
+    FeatureExtractor(int freq, size_t size);
+
+    size_t get_size() const { return fft.get_size(); }
+
+    Features process(const float *frame);
+    void reset();
+
+private:
+    FFT fft;
+    std::vector<float> window;
+    float window_energy;
+    size_t low_end;
+    size_t mid_end;
+    std::vector<float> real;
+    std::vector<float> imag;
+    std::vector<float> spectrum;
+    std::vector<float> previous;
+    bool has_previous;
+};
+
+std::vector<FeatureExtractor::Features> extract_features(const std::vector<float> &samples, int freq,
+                                                         size_t frame_size, size_t hop_size,
+                                                         unsigned int num_threads);
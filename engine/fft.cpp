@@ -0,0 +1,150 @@
+#include "fft.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FFT_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+inline void radix4(float *re, float *im, size_t j, size_t h,
+                   float ar, float ai, float br, float bi)
+{
+    const float x0r = re[j],         x0i = im[j];
+    const float x1r = re[j + h],     x1i = im[j + h];
+    const float x2r = re[j + 2 * h], x2i = im[j + 2 * h];
+    const float x3r = re[j + 3 * h], x3i = im[j + 3 * h];
+
+    const float t1r = ar * x1r - ai * x1i, t1i = ar * x1i + ai * x1r;
+    const float t3r = ar * x3r - ai * x3i, t3i = ar * x3i + ai * x3r;
+    const float a0r = x0r + t1r, a0i = x0i + t1i;
+    const float a1r = x0r - t1r, a1i = x0i - t1i;
+    const float b0r = x2r + t3r, b0i = x2i + t3i;
+    const float b1r = x2r - t3r, b1i = x2i - t3i;
+
+    const float u0r = br * b0r - bi * b0i, u0i = br * b0i + bi * b0r;
+    const float u1r = br * b1r - bi * b1i, u1i = br * b1i + bi * b1r;
+
+    re[j]         = a0r + u0r; im[j]         = a0i + u0i;
+    re[j + 2 * h] = a0r - u0r; im[j + 2 * h] = a0i - u0i;
+    re[j + h]     = a1r + u1i; im[j + h]     = a1i - u1r;
+    re[j + 3 * h] = a1r - u1i; im[j + 3 * h] = a1i + u1r;
+}
+
+#ifdef FFT_SSE
+inline void radix4_sse(float *re, float *im, size_t j, size_t h,
+                       const float *ar, const float *ai, const float *br, const float *bi)
+{
+    const __m128 war = _mm_loadu_ps(ar + j), wai = _mm_loadu_ps(ai + j);
+    const __m128 wbr = _mm_loadu_ps(br + j), wbi = _mm_loadu_ps(bi + j);
+
+    const __m128 x0r = _mm_loadu_ps(re + j),         x0i = _mm_loadu_ps(im + j);
+    const __m128 x1r = _mm_loadu_ps(re + j + h),     x1i = _mm_loadu_ps(im + j + h);
+    const __m128 x2r = _mm_loadu_ps(re + j + 2 * h), x2i = _mm_loadu_ps(im + j + 2 * h);
+    const __m128 x3r = _mm_loadu_ps(re + j + 3 * h), x3i = _mm_loadu_ps(im + j + 3 * h);
+
+    const __m128 t1r = _mm_sub_ps(_mm_mul_ps(war, x1r), _mm_mul_ps(wai, x1i));
+    const __m128 t1i = _mm_add_ps(_mm_mul_ps(war, x1i), _mm_mul_ps(wai, x1r));
+    const __m128 t3r = _mm_sub_ps(_mm_mul_ps(war, x3r), _mm_mul_ps(wai, x3i));
+    const __m128 t3i = _mm_add_ps(_mm_mul_ps(war, x3i), _mm_mul_ps(wai, x3r));
+    const __m128 a0r = _mm_add_ps(x0r, t1r), a0i = _mm_add_ps(x0i, t1i);
+    const __m128 a1r = _mm_sub_ps(x0r, t1r), a1i = _mm_sub_ps(x0i, t1i);
+    const __m128 b0r = _mm_add_ps(x2r, t3r), b0i = _mm_add_ps(x2i, t3i);
+    const __m128 b1r = _mm_sub_ps(x2r, t3r), b1i = _mm_sub_ps(x2i, t3i);
+
+    const __m128 u0r = _mm_sub_ps(_mm_mul_ps(wbr, b0r), _mm_mul_ps(wbi, b0i));
+    const __m128 u0i = _mm_add_ps(_mm_mul_ps(wbr, b0i), _mm_mul_ps(wbi, b0r));
+    const __m128 u1r = _mm_sub_ps(_mm_mul_ps(wbr, b1r), _mm_mul_ps(wbi, b1i));
+    const __m128 u1i = _mm_add_ps(_mm_mul_ps(wbr, b1i), _mm_mul_ps(wbi, b1r));
+
+    _mm_storeu_ps(re + j,         _mm_add_ps(a0r, u0r)); _mm_storeu_ps(im + j,         _mm_add_ps(a0i, u0i));
+    _mm_storeu_ps(re + j + 2 * h, _mm_sub_ps(a0r, u0r)); _mm_storeu_ps(im + j + 2 * h, _mm_sub_ps(a0i, u0i));
+    _mm_storeu_ps(re + j + h,     _mm_add_ps(a1r, u1i)); _mm_storeu_ps(im + j + h,     _mm_sub_ps(a1i, u1r));
+    _mm_storeu_ps(re + j + 3 * h, _mm_sub_ps(a1r, u1i)); _mm_storeu_ps(im + j + 3 * h, _mm_add_ps(a1i, u1r));
+}
+#endif
+
+}
+
+FFT::FFT(size_t size)
+  : size(size),
+    radix2_first(false),
+    reversed(size)
+{
+    if (size < 2 || (size & (size - 1)) != 0) {
+        throw std::runtime_error("FFT size must be a power of two");
+    }
+
+    unsigned int bits = 0;
+    while ((size_t(1) << bits) < size) {
+        ++bits;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        size_t r = 0;
+        for (unsigned int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        reversed[i] = r;
+    }
+
+    radix2_first = (bits % 2) == 1;
+    for (size_t h = radix2_first ? 2 : 1; 4 * h <= size; h *= 4) {
+        Stage stage;
+        stage.half = h;
+        for (size_t j = 0; j < h; ++j) {
+            const double inner = -2.0 * PI * static_cast<double>(j) / static_cast<double>(2 * h);
+            const double outer = -2.0 * PI * static_cast<double>(j) / static_cast<double>(4 * h);
+            stage.inner_real.push_back(static_cast<float>(std::cos(inner)));
+            stage.inner_imag.push_back(static_cast<float>(std::sin(inner)));
+            stage.outer_real.push_back(static_cast<float>(std::cos(outer)));
+            stage.outer_imag.push_back(static_cast<float>(std::sin(outer)));
+        }
+        stages.push_back(std::move(stage));
+    }
+}
+
+void FFT::transform(float *real, float *imag) const {
+    for (size_t i = 0; i < size; ++i) {
+        const size_t r = reversed[i];
+        if (i < r) {
+            std::swap(real[i], real[r]);
+            std::swap(imag[i], imag[r]);
+        }
+    }
+
+    if (radix2_first) {
+        for (size_t k = 0; k < size; k += 2) {
+            const float ur = real[k], ui = imag[k];
+            const float tr = real[k + 1], ti = imag[k + 1];
+            real[k] = ur + tr; imag[k] = ui + ti;
+            real[k + 1] = ur - tr; imag[k + 1] = ui - ti;
+        }
+    }
+
+    for (const Stage &stage : stages) {
+        const size_t h = stage.half;
+        const float *ar = stage.inner_real.data();
+        const float *ai = stage.inner_imag.data();
+        const float *br = stage.outer_real.data();
+        const float *bi = stage.outer_imag.data();
+        for (size_t k = 0; k < size; k += 4 * h) {
+            float *re = real + k;
+            float *im = imag + k;
+            size_t j = 0;
+#ifdef FFT_SSE
+            for (; j + 4 <= h; j += 4) {
+                radix4_sse(re, im, j, h, ar, ai, br, bi);
+            }
+#endif
+            for (; j < h; ++j) {
+                radix4(re, im, j, h, ar[j], ai[j], br[j], bi[j]);
+            }
+        }
+    }
+}
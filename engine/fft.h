@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class FFT {
+public:
+    explicit FFT(size_t size);
+
+    size_t get_size() const { return size; }
+
+    void transform(float *real, float *imag) const;
+
+private:
+    struct Stage {
+        size_t half;
+        std::vector<float> inner_real;
+        std::vector<float> inner_imag;
+        std::vector<float> outer_real;
+        std::vector<float> outer_imag;
+    };
+
+    size_t size;
+    bool radix2_first;
+    std::vector<size_t> reversed;
+    std::vector<Stage> stages;
+};
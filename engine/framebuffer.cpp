@@ -1,17 +1,18 @@
 #include "framebuffer.h"
 
+#include "glstate.h"
 #include "renderbuffer.h"
 #include "texture.h"
 
 Framebuffer::Binding::Binding(GLenum target, const Framebuffer &framebuffer)
   : target(target)
 {
-    glBindFramebuffer(target, framebuffer.id);
+    GLState::get().bind_framebuffer(target, framebuffer.id);
 }
 
 Framebuffer::Binding::~Binding() {
     if (target) {
-        glBindFramebuffer(*target, 0);
+        GLState::get().release_framebuffer(*target);
     }
 }
 
@@ -40,6 +41,7 @@ Framebuffer::Framebuffer() {
 }
 
 Framebuffer::~Framebuffer() {
+    GLState::get().forget_framebuffer(id);
     glDeleteFramebuffers(1, &id);
 }
 
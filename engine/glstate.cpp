@@ -0,0 +1,216 @@
+#include "glstate.h"
+
+#include <limits>
+
+namespace {
+
+const GLuint UNKNOWN = std::numeric_limits<GLuint>::max();
+
+GLuint &lookup(std::map<GLenum, GLuint> &bindings, GLenum target) {
+    return bindings.try_emplace(target, UNKNOWN).first->second;
+}
+
+}
+
+GLState &GLState::get() {
+    static GLState state;
+    return state;
+}
+
+GLState::GLState()
+  : tracking(true),
+    direct_state_access(GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access),
+    parallel_shader_compile(GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile),
+    calls(0),
+    saved(0)
+{
+    invalidate();
+}
+
+void GLState::set_tracking(bool tracking) {
+    this->tracking = tracking;
+    invalidate();
+}
+
+// Counts the call a binding takes, or the one it saves.
+bool GLState::update(GLuint &current, GLuint id) {
+    if (tracking && current == id) {
+        ++saved;
+        return false;
+    }
+    current = id;
+    ++calls;
+    return true;
+}
+
+// An element array buffer bound while a vertex array is left bound from an
+// earlier binding would replace the one of that vertex array.
+void GLState::bind_buffer(GLenum target, GLuint id) {
+    if (target == GL_ELEMENT_ARRAY_BUFFER && !vertex_array_held && vertex_array != 0) {
+        if (update(vertex_array, 0)) {
+            glBindVertexArray(0);
+        }
+        buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+    if (update(lookup(buffers, target), id)) {
+        glBindBuffer(target, id);
+    }
+}
+
+void GLState::release_buffer(GLenum target) {
+    if (!tracking) {
+        bind_buffer(target, 0);
+    }
+}
+
+void GLState::bind_buffer_base(GLenum target, GLuint index, GLuint id) {
+    lookup(buffers, target) = id;
+    ++calls;
+    glBindBufferBase(target, index, id);
+}
+
+void GLState::bind_vertex_array(GLuint id) {
+    vertex_array_held = true;
+    if (update(vertex_array, id)) {
+        glBindVertexArray(id);
+        buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+void GLState::release_vertex_array() {
+    vertex_array_held = false;
+    if (!tracking && update(vertex_array, 0)) {
+        glBindVertexArray(0);
+        buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+void GLState::activate_texture(GLenum unit) {
+    if (update(active_texture, unit)) {
+        glActiveTexture(unit);
+    }
+}
+
+void GLState::bind_texture(GLenum unit, GLenum target, GLuint id) {
+    GLuint &current = textures.try_emplace({ unit, target }, UNKNOWN).first->second;
+    if (tracking && current == id) {
+        ++saved;
+        return;
+    }
+    activate_texture(unit);
+    if (update(current, id)) {
+        glBindTexture(target, id);
+    }
+}
+
+void GLState::release_texture(GLenum unit, GLenum target) {
+    if (!tracking) {
+        bind_texture(unit, target, 0);
+    }
+}
+
+void GLState::bind_framebuffer(GLenum target, GLuint id) {
+    if (target == GL_FRAMEBUFFER) {
+        if (tracking && draw_framebuffer == id && read_framebuffer == id) {
+            ++saved;
+            return;
+        }
+        draw_framebuffer = id;
+        read_framebuffer = id;
+        ++calls;
+        glBindFramebuffer(target, id);
+    } else if (update(target == GL_READ_FRAMEBUFFER ? read_framebuffer : draw_framebuffer, id)) {
+        glBindFramebuffer(target, id);
+    }
+}
+
+void GLState::release_framebuffer(GLenum target) {
+    if (!tracking) {
+        bind_framebuffer(target, 0);
+    }
+}
+
+void GLState::bind_renderbuffer(GLenum target, GLuint id) {
+    if (update(renderbuffer, id)) {
+        glBindRenderbuffer(target, id);
+    }
+}
+
+void GLState::release_renderbuffer(GLenum target) {
+    if (!tracking) {
+        bind_renderbuffer(target, 0);
+    }
+}
+
+void GLState::use_program(GLuint id) {
+    if (update(program, id)) {
+        glUseProgram(id);
+    }
+}
+
+void GLState::release_program() {
+    if (!tracking) {
+        use_program(0);
+    }
+}
+
+void GLState::forget_buffer(GLuint id) {
+    for (auto &binding : buffers) {
+        if (binding.second == id) {
+            binding.second = UNKNOWN;
+        }
+    }
+}
+
+void GLState::forget_vertex_array(GLuint id) {
+    if (vertex_array == id) {
+        vertex_array = UNKNOWN;
+        buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    }
+}
+
+void GLState::forget_texture(GLuint id) {
+    for (auto &binding : textures) {
+        if (binding.second == id) {
+            binding.second = UNKNOWN;
+        }
+    }
+}
+
+void GLState::forget_framebuffer(GLuint id) {
+    if (draw_framebuffer == id) {
+        draw_framebuffer = UNKNOWN;
+    }
+    if (read_framebuffer == id) {
+        read_framebuffer = UNKNOWN;
+    }
+}
+
+void GLState::forget_renderbuffer(GLuint id) {
+    if (renderbuffer == id) {
+        renderbuffer = UNKNOWN;
+    }
+}
+
+void GLState::forget_program(GLuint id) {
+    if (program == id) {
+        program = UNKNOWN;
+    }
+}
+
+void GLState::invalidate() {
+    buffers.clear();
+    vertex_array = UNKNOWN;
+    vertex_array_held = false;
+    active_texture = UNKNOWN;
+    textures.clear();
+    draw_framebuffer = UNKNOWN;
+    read_framebuffer = UNKNOWN;
+    renderbuffer = UNKNOWN;
+    program = UNKNOWN;
+}
+
+void GLState::reset_counts() {
+    calls = 0;
+    saved = 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <map>
+#include <utility>
+
+// Keeps track of the objects bound in the GL context, so that binding an
+// object that's already bound costs no call. When a binding of one of the
+// wrappers ends, the object is left bound instead of binding 0, and only
+// replaced by the next binding, which saves most calls of passes that bind
+// the same objects again. Without tracking, every binding is made and
+// undone on the spot.
+//
+// The element array buffer belongs to the vertex array, so it's never bound
+// without one, and the objects that are deleted are forgotten, as their
+// names are reused. Whoever binds objects behind the back of the wrappers
+// has to call invalidate().
+//
+// With GL 4.5 or ARB_direct_state_access, objects are created with
+// glCreate*() and edited without being bound where the wrappers can. With
+// KHR_parallel_shader_compile or its ARB twin, programs can be asked whether
+// they're done linking without waiting for it.
+class GLState {
+public:
+    // There's a single context, created before the first call.
+    static GLState &get();
+
+    void set_tracking(bool tracking);
+    bool is_tracking() const { return tracking; }
+    bool has_direct_state_access() const { return direct_state_access; }
+    bool has_parallel_shader_compile() const { return parallel_shader_compile; }
+
+    void bind_buffer(GLenum target, GLuint id);
+    void release_buffer(GLenum target);
+    // Binds to an indexed target, such as a uniform block binding point,
+    // which also binds to the target itself.
+    void bind_buffer_base(GLenum target, GLuint index, GLuint id);
+    void bind_vertex_array(GLuint id);
+    void release_vertex_array();
+    void activate_texture(GLenum unit);
+    void bind_texture(GLenum unit, GLenum target, GLuint id);
+    void release_texture(GLenum unit, GLenum target);
+    void bind_framebuffer(GLenum target, GLuint id);
+    void release_framebuffer(GLenum target);
+    void bind_renderbuffer(GLenum target, GLuint id);
+    void release_renderbuffer(GLenum target);
+    void use_program(GLuint id);
+    void release_program();
+
+    void forget_buffer(GLuint id);
+    void forget_vertex_array(GLuint id);
+    void forget_texture(GLuint id);
+    void forget_framebuffer(GLuint id);
+    void forget_renderbuffer(GLuint id);
+    void forget_program(GLuint id);
+    void invalidate();
+
+    // The binding calls made and saved since reset_counts().
+    size_t get_num_calls() const { return calls; }
+    size_t get_num_saved() const { return saved; }
+    void reset_counts();
+
+    GLState(const GLState &) = delete;
+    GLState &operator = (const GLState &) = delete;
+private:
+    bool tracking;
+    bool direct_state_access;
+    bool parallel_shader_compile;
+    std::map<GLenum, GLuint> buffers;
+    GLuint vertex_array;
+    bool vertex_array_held;
+    GLenum active_texture;
+    std::map<std::pair<GLenum, GLenum>, GLuint> textures;
+    GLuint draw_framebuffer;
+    GLuint read_framebuffer;
+    GLuint renderbuffer;
+    GLuint program;
+    size_t calls;
+    size_t saved;
+
+    GLState();
+
+    bool update(GLuint &current, GLuint id);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename);
+    ~MappedFile();
+
+    const void *get_data() const { return data; }
+    size_t get_size() const { return size; }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator = (const MappedFile &) = delete;
+private:
+    void *data;
+    size_t size;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#endif
+};
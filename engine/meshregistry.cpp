@@ -0,0 +1,55 @@
+#include "meshregistry.h"
+
+#include <cstring>
+#include <stdexcept>
+
+MeshRegistry::MeshRegistry()
+  : uploaded(false)
+{ }
+
+size_t MeshRegistry::add(const std::vector<GLfloat> &positions) {
+    if (positions.size() % 9 != 0) {
+        throw std::runtime_error("Meshes must consist of whole triangles");
+    }
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (meshes[i].positions == positions) {
+            return i;
+        }
+    }
+
+    const size_t base = vertices.size() / 3;
+    Mesh mesh{ static_cast<GLint>(base), static_cast<GLsizei>(indices.size()), static_cast<GLsizei>(positions.size() / 3) };
+    for (size_t i = 0; i < positions.size(); i += 3) {
+        size_t index = base;
+        while (index < vertices.size() / 3 && memcmp(&vertices[index * 3], &positions[i], 3 * sizeof(GLfloat)) != 0) {
+            ++index;
+        }
+        if (index == vertices.size() / 3) {
+            vertices.insert(vertices.end(), positions.begin() + i, positions.begin() + i + 3);
+        }
+        indices.push_back(static_cast<GLuint>(index - base));
+    }
+    meshes.push_back({ positions, mesh });
+    uploaded = false;
+    return meshes.size() - 1;
+}
+
+void MeshRegistry::bind(const VertexArray::Binding &vao, GLuint attribute) {
+    if (!uploaded) {
+        vertex_buffer.data(vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+        index_buffer.data(indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        uploaded = true;
+    }
+    auto binding = vertex_buffer.bind(GL_ARRAY_BUFFER);
+    binding.vertex_attrib_pointer(vao, attribute, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 3, nullptr);
+}
+
+Buffer::Binding MeshRegistry::bind_indices() const {
+    return index_buffer.bind(GL_ELEMENT_ARRAY_BUFFER);
+}
+
+void MeshRegistry::draw_instanced(size_t handle, GLsizei instances) const {
+    const Mesh &mesh = meshes[handle].mesh;
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.count, GL_UNSIGNED_INT,
+        reinterpret_cast<const void *>(mesh.first_index * sizeof(GLuint)), instances, mesh.base_vertex);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "buffer.h"
+#include "vertexarray.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+// Packs the geometry of all meshes into one static vertex buffer and one
+// index buffer. Meshes are lists of triangles given as positions with three
+// components per vertex. Identical meshes are stored once, and so are the
+// repeated vertices of a mesh.
+class MeshRegistry {
+public:
+    struct Mesh {
+        GLint base_vertex;
+        GLsizei first_index;
+        GLsizei count;
+    };
+
+    MeshRegistry();
+
+    size_t add(const std::vector<GLfloat> &positions);
+    const Mesh &get(size_t handle) const { return meshes[handle].mesh; }
+
+    size_t get_num_meshes() const { return meshes.size(); }
+    size_t get_num_vertices() const { return vertices.size() / 3; }
+    size_t get_num_indices() const { return indices.size(); }
+
+    // Uploads the buffers if meshes were added since, and points the
+    // attribute at the positions. The index buffer has to be bound while
+    // drawing, as unbinding it with the vertex array bound would remove it
+    // from the vertex array.
+    void bind(const VertexArray::Binding &vao, GLuint attribute);
+    Buffer::Binding bind_indices() const;
+
+    void draw_instanced(size_t handle, GLsizei instances) const;
+
+    MeshRegistry(const MeshRegistry &) = delete;
+    MeshRegistry &operator = (const MeshRegistry &) = delete;
+private:
+    struct Entry {
+        std::vector<GLfloat> positions;
+        Mesh mesh;
+    };
+
+    std::vector<Entry> meshes;
+    std::vector<GLfloat> vertices;
+    std::vector<GLuint> indices;
+    Buffer vertex_buffer;
+    Buffer index_buffer;
+    bool uploaded;
+};
@@ -0,0 +1,215 @@
+#include "mixer.h"
+
+#include "analyzer.h"
+#include "samples.h"
+#include "wave.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MIXER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const size_t BLOCK_FRAMES = 1024;
+const size_t FADE_FRAMES = 256;
+const size_t NO_SEEK = static_cast<size_t>(-1);
+
+// Adds in * gain to out, with the gain ramping linearly by step per sample.
+void accumulate(float *out, const float *in, size_t count, float gain, float step) {
+    size_t i = 0;
+#ifdef MIXER_SSE
+    __m128 g = _mm_setr_ps(gain, gain + step, gain + 2.0f * step, gain + 3.0f * step);
+    const __m128 g_step = _mm_set1_ps(4.0f * step);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_mul_ps(_mm_loadu_ps(in + i), g);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), x));
+        g = _mm_add_ps(g, g_step);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] += in[i] * (gain + step * static_cast<float>(i));
+    }
+}
+
+}
+
+Mixer::Mixer(const SDL_AudioSpec &spec)
+  : spec(spec),
+    bytes_per_frame(spec.channels * get_sample_size(spec.format)),
+    length(0),
+    position(0),
+    pending_seek(NO_SEEK),
+    fade_position(0),
+    fade_remaining(0),
+    sequence(0),
+    playhead_position(0),
+    playhead_counter(SDL_GetPerformanceCounter()),
+    scratch(BLOCK_FRAMES * spec.channels),
+    sum(BLOCK_FRAMES * spec.channels),
+    fade(BLOCK_FRAMES * spec.channels)
+{
+    if (!is_supported_format(spec.format)) {
+        throw std::runtime_error("Unsupported audio format for mixing");
+    }
+}
+
+size_t Mixer::add_source(const std::string &name, std::unique_ptr<Source> source) {
+    auto stem = std::make_unique<Stem>();
+    stem->name = name;
+    stem->source = std::move(source);
+    stem->analyzer = nullptr;
+    stem->gain.store(1.0f);
+    stem->muted.store(false);
+    stem->current_gain = 1.0f;
+    length = std::max(length, stem->source->get_length());
+    stems.push_back(std::move(stem));
+    return stems.size() - 1;
+}
+
+void Mixer::set_analyzer(size_t index, Analyzer *analyzer) {
+    stems.at(index)->analyzer = analyzer;
+}
+
+const std::string &Mixer::get_name(size_t index) const {
+    return stems.at(index)->name;
+}
+
+float Mixer::get_gain(size_t index) const {
+    return stems.at(index)->gain.load(std::memory_order_relaxed);
+}
+
+void Mixer::set_gain(size_t index, float gain) {
+    stems.at(index)->gain.store(gain, std::memory_order_relaxed);
+}
+
+bool Mixer::is_muted(size_t index) const {
+    return stems.at(index)->muted.load(std::memory_order_relaxed);
+}
+
+void Mixer::set_muted(size_t index, bool muted) {
+    stems.at(index)->muted.store(muted, std::memory_order_relaxed);
+}
+
+Mixer::Playhead Mixer::get_playhead() const {
+    Playhead playhead;
+    unsigned int before;
+    do {
+        before = sequence.load(std::memory_order_acquire);
+        playhead.position = playhead_position.load(std::memory_order_relaxed);
+        playhead.counter = playhead_counter.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((before & 1) != 0 || before != sequence.load(std::memory_order_relaxed));
+    return playhead;
+}
+
+// The seek is carried out by the next call to mix(), but the playhead jumps
+// to the target right away, so the render clock never shows the old position
+// with the new timestamp or vice versa.
+void Mixer::seek(size_t position, float latency) {
+    position = std::min(position, length);
+    unsigned int expected = sequence.load(std::memory_order_relaxed);
+    do {
+        expected &= ~1u;
+    } while (!sequence.compare_exchange_weak(expected, expected + 1, std::memory_order_acquire, std::memory_order_relaxed));
+    pending_seek.store(position, std::memory_order_relaxed);
+    playhead_position.store(position, std::memory_order_relaxed);
+    const Uint64 ahead = static_cast<Uint64>(std::max(latency, 0.0f) * SDL_GetPerformanceFrequency() / 1000.0);
+    playhead_counter.store(SDL_GetPerformanceCounter() - ahead, std::memory_order_relaxed);
+    sequence.store(expected + 2, std::memory_order_release);
+}
+
+// Called from the audio callback only: if a seek holds the sequence, the seek
+// publishes the newer playhead anyway, so there is no reason to wait for it.
+void Mixer::publish(size_t position, Uint64 counter) {
+    unsigned int expected = sequence.load(std::memory_order_relaxed);
+    if ((expected & 1) != 0 || !sequence.compare_exchange_strong(expected, expected + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+    }
+    if (pending_seek.load(std::memory_order_relaxed) == NO_SEEK) {
+        playhead_position.store(position, std::memory_order_relaxed);
+        playhead_counter.store(counter, std::memory_order_relaxed);
+    }
+    sequence.store(expected + 2, std::memory_order_release);
+}
+
+int Mixer::mix(Uint8 *data, int len) {
+    const size_t target = pending_seek.exchange(NO_SEEK, std::memory_order_acquire);
+    if (target != NO_SEEK && target != position) {
+        fade_position = position;
+        fade_remaining = position < length ? FADE_FRAMES : 0;
+        position = target;
+    }
+
+    const size_t frames = static_cast<size_t>(len) / bytes_per_frame;
+    size_t done = 0;
+    while (done < frames && (position < length || fade_remaining > 0)) {
+        size_t count = std::min(BLOCK_FRAMES, frames - done);
+        if (fade_remaining > 0) {
+            count = std::min(count, fade_remaining);
+        } else {
+            count = std::min(count, length - position);
+        }
+        const size_t samples = count * spec.channels;
+        std::fill(sum.begin(), sum.begin() + samples, 0.0f);
+        if (fade_remaining > 0) {
+            std::fill(fade.begin(), fade.begin() + samples, 0.0f);
+        }
+        for (const auto &stem : stems) {
+            if (fade_remaining > 0 && stem->current_gain != 0.0f) {
+                stem->source->read(fade_position, scratch.data(), count);
+                accumulate(fade.data(), scratch.data(), samples, stem->current_gain, 0.0f);
+            }
+            stem->source->read(position, scratch.data(), count);
+            if (stem->analyzer != nullptr) {
+                stem->analyzer->push(scratch.data(), count);
+            }
+            const float target = stem->muted.load(std::memory_order_relaxed) ? 0.0f : stem->gain.load(std::memory_order_relaxed);
+            const float step = (target - stem->current_gain) / static_cast<float>(samples);
+            if (stem->current_gain != 0.0f || target != 0.0f) {
+                accumulate(sum.data(), scratch.data(), samples, stem->current_gain, step);
+            }
+            stem->current_gain = target;
+        }
+        if (fade_remaining > 0) {
+            for (size_t i = 0; i < count; ++i) {
+                const float out = static_cast<float>(fade_remaining - i) / static_cast<float>(FADE_FRAMES);
+                for (int c = 0; c < spec.channels; ++c) {
+                    const size_t k = i * spec.channels + c;
+                    sum[k] += out * (fade[k] - sum[k]);
+                }
+            }
+            fade_position += count;
+            fade_remaining -= count;
+        }
+        convert_from_float(sum.data(), samples, spec.format, data + done * bytes_per_frame);
+        done += count;
+        position = std::min(position + count, length);
+    }
+    if (done < frames) {
+        memset(data + done * bytes_per_frame, spec.silence, (frames - done) * bytes_per_frame);
+    }
+    publish(position, SDL_GetPerformanceCounter());
+    return static_cast<int>(done * bytes_per_frame);
+}
+
+WaveSource::WaveSource(const Wave &wave, const SDL_AudioSpec &spec)
+  : channels(spec.channels)
+{
+    SDL_AudioSpec f32 = spec;
+    f32.format = AUDIO_F32SYS;
+    const std::vector<Uint8> converted = wave.convert_to_spec(f32);
+    samples.resize(converted.size() / sizeof(float));
+    memcpy(samples.data(), converted.data(), samples.size() * sizeof(float));
+    length = samples.size() / channels;
+}
+
+void WaveSource::read(size_t position, float *out, size_t frames) {
+    const size_t available = position < length ? std::min(frames, length - position) : 0;
+    memcpy(out, samples.data() + position * channels, available * channels * sizeof(float));
+    std::fill(out + available * channels, out + frames * channels, 0.0f);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Analyzer;
+class Wave;
+
+class Mixer {
+public:
+    class Source {
+    public:
+        virtual ~Source() = default;
+
+        virtual size_t get_length() const = 0;
+        virtual void read(size_t position, float *out, size_t frames) = 0;
+    };
+
+    struct Playhead {
+        size_t position;
+        Uint64 counter;
+    };
+
+    explicit Mixer(const SDL_AudioSpec &spec);
+
+    size_t add_source(const std::string &name, std::unique_ptr<Source> source);
+    void set_analyzer(size_t index, Analyzer *analyzer);
+
+    size_t get_num_sources() const { return stems.size(); }
+    const std::string &get_name(size_t index) const;
+    float get_gain(size_t index) const;
+    void set_gain(size_t index, float gain);
+    bool is_muted(size_t index) const;
+    void set_muted(size_t index, bool muted);
+
+    const SDL_AudioSpec &get_spec() const { return spec; }
+    size_t get_length() const { return length; }
+    size_t get_position() const { return get_playhead().position; }
+    Playhead get_playhead() const;
+    // The playhead is published as if the target had already been playing
+    // for latency milliseconds, so a clock that subtracts the output latency
+    // reads the target right away, while the mixer starts exactly there.
+    void seek(size_t position, float latency = 0.0f);
+
+    int mix(Uint8 *data, int len);
+
+    Mixer(const Mixer &) = delete;
+    Mixer &operator = (const Mixer &) = delete;
+private:
+    struct Stem {
+        std::string name;
+        std::unique_ptr<Source> source;
+        Analyzer *analyzer;
+        std::atomic<float> gain;
+        std::atomic<bool> muted;
+        float current_gain;
+    };
+
+    SDL_AudioSpec spec;
+    size_t bytes_per_frame;
+    size_t length;
+    std::vector<std::unique_ptr<Stem>> stems;
+    size_t position;
+    std::atomic<size_t> pending_seek;
+    size_t fade_position;
+    size_t fade_remaining;
+    std::atomic<unsigned int> sequence;
+    std::atomic<size_t> playhead_position;
+    std::atomic<Uint64> playhead_counter;
+    std::vector<float> scratch;
+    std::vector<float> sum;
+    std::vector<float> fade;
+
+    void publish(size_t position, Uint64 counter);
+};
+
+class WaveSource : public Mixer::Source {
+public:
+    WaveSource(const Wave &wave, const SDL_AudioSpec &spec);
+
+    size_t get_length() const override { return length; }
+    void read(size_t position, float *out, size_t frames) override;
+
+private:
+    int channels;
+    size_t length;
+    std::vector<float> samples;
+};
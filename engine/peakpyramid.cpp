@@ -0,0 +1,94 @@
+#include "peakpyramid.h"
+
+#include "qoafile.h"
+#include "wave.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+PeakPyramid::Peak merge(const PeakPyramid::Peak &a, const PeakPyramid::Peak &b) {
+    return { std::min(a.min, b.min), std::max(a.max, b.max), 0.5f * (a.power + b.power) };
+}
+
+}
+
+PeakPyramid::PeakPyramid(const Wave &wave, size_t block_frames)
+  : frequency(wave.get_spec().freq),
+    block_frames(block_frames),
+    ready(false)
+{
+    worker = std::thread(&PeakPyramid::build, this, [&wave] { return wave.get_mono_samples(); });
+}
+
+PeakPyramid::PeakPyramid(const QOAFile &file, size_t block_frames)
+  : frequency(file.get_frequency()),
+    block_frames(block_frames),
+    ready(false)
+{
+    worker = std::thread(&PeakPyramid::build, this, [&file] { return file.get_mono_samples(); });
+}
+
+PeakPyramid::~PeakPyramid() {
+    worker.join();
+}
+
+void PeakPyramid::build(std::function<std::vector<float>()> load) {
+    const std::vector<float> samples = load();
+
+    std::vector<Peak> level((samples.size() + block_frames - 1) / block_frames);
+    for (size_t i = 0; i < level.size(); ++i) {
+        const size_t begin = i * block_frames;
+        const size_t end = std::min(samples.size(), begin + block_frames);
+        Peak peak = { samples[begin], samples[begin], 0.0f };
+        for (size_t j = begin; j < end; ++j) {
+            peak.min = std::min(peak.min, samples[j]);
+            peak.max = std::max(peak.max, samples[j]);
+            peak.power += samples[j] * samples[j];
+        }
+        peak.power /= static_cast<float>(end - begin);
+        level[i] = peak;
+    }
+    levels.push_back(std::move(level));
+
+    while (levels.back().size() > 1) {
+        const std::vector<Peak> &finer = levels.back();
+        std::vector<Peak> coarser((finer.size() + 1) / 2);
+        for (size_t i = 0; i < coarser.size(); ++i) {
+            coarser[i] = 2 * i + 1 < finer.size() ? merge(finer[2 * i], finer[2 * i + 1]) : finer[2 * i];
+        }
+        levels.push_back(std::move(coarser));
+    }
+
+    ready.store(true, std::memory_order_release);
+}
+
+PeakPyramid::Peak PeakPyramid::get_peak(size_t begin, size_t end) const {
+    if (!is_ready() || levels.empty() || end <= begin) {
+        return { 0.0f, 0.0f, 0.0f };
+    }
+
+    // The coarsest level whose blocks still fit into the range touches at
+    // most three blocks, whatever the length of the song.
+    size_t level = 0;
+    while (level + 1 < levels.size() && (block_frames << (level + 1)) <= end - begin) {
+        ++level;
+    }
+    const std::vector<Peak> &peaks = levels[level];
+    const size_t block = block_frames << level;
+    const size_t first = begin / block;
+    const size_t last = std::min(peaks.size(), (end + block - 1) / block);
+    if (first >= last) {
+        return { 0.0f, 0.0f, 0.0f };
+    }
+
+    Peak result = peaks[first];
+    for (size_t i = first + 1; i < last; ++i) {
+        result.min = std::min(result.min, peaks[i].min);
+        result.max = std::max(result.max, peaks[i].max);
+        result.power += peaks[i].power;
+    }
+    result.power /= static_cast<float>(last - first);
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+class QOAFile;
+class Wave;
+
+class PeakPyramid {
+public:
+    struct Peak {
+        float min;
+        float max;
+        float power;
+    };
+
+    explicit PeakPyramid(const Wave &wave, size_t block_frames = 64);
+    explicit PeakPyramid(const QOAFile &file, size_t block_frames = 64);
+    ~PeakPyramid();
+
+    bool is_ready() const { return ready.load(std::memory_order_acquire); }
+    int get_frequency() const { return frequency; }
+
+    Peak get_peak(size_t begin, size_t end) const;
+
+    PeakPyramid(const PeakPyramid &) = delete;
+    PeakPyramid &operator = (const PeakPyramid &) = delete;
+private:
+    int frequency;
+    size_t block_frames;
+    std::vector<std::vector<Peak>> levels;
+    std::atomic<bool> ready;
+    std::thread worker;
+
+    void build(std::function<std::vector<float>()> load);
+};
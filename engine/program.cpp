@@ -1,7 +1,10 @@
 #include "program.h"
 
+#include "glstate.h"
+
 #include <glm/gtc/type_ptr.hpp>
 
+#include <utility>
 #include <vector>
 
 Program::Exception::Exception(const char *message)
@@ -10,35 +13,56 @@ Program::Exception::Exception(const char *message)
 Program::Usage::Usage(const Program &program)
   : program(&program)
 {
-    glUseProgram(program.id);
+    GLState::get().use_program(program.id);
 }
 
 Program::Usage::~Usage() {
-    glUseProgram(0);
+    GLState::get().release_program();
 }
 
 void Program::Usage::set_uniform(const char *name, const glm::mat4x4 &m, bool transpose) const {
-    glUniformMatrix4fv(glGetUniformLocation(program->id, name), 1, transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(m));
+    set_uniform(program->get_uniform<glm::mat4x4>(name), m, transpose);
 }
 
 void Program::Usage::set_uniform(const char *name, const glm::mat2 &m, bool transpose) const {
-    glUniformMatrix2fv(glGetUniformLocation(program->id, name), 1, transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(m));
+    set_uniform(program->get_uniform<glm::mat2>(name), m, transpose);
 }
 
 void Program::Usage::set_uniform(const char *name, const glm::vec3 &v) const {
-    glUniform3fv(glGetUniformLocation(program->id, name), 1, glm::value_ptr(v));
+    set_uniform(program->get_uniform<glm::vec3>(name), v);
 }
 
 void Program::Usage::set_uniform(const char *name, GLint x) const {
-    glUniform1i(glGetUniformLocation(program->id, name), x);
+    set_uniform(program->get_uniform<GLint>(name), x);
 }
 
 void Program::Usage::set_uniform(const char *name, GLfloat x) const {
-    glUniform1f(glGetUniformLocation(program->id, name), x);
+    set_uniform(program->get_uniform<GLfloat>(name), x);
+}
+
+void Program::Usage::set_uniform(const Uniform<glm::mat4x4> &uniform, const glm::mat4x4 &m, bool transpose) const {
+    glUniformMatrix4fv(uniform.get_location(), 1, transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(m));
+}
+
+void Program::Usage::set_uniform(const Uniform<glm::mat2> &uniform, const glm::mat2 &m, bool transpose) const {
+    glUniformMatrix2fv(uniform.get_location(), 1, transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(m));
+}
+
+void Program::Usage::set_uniform(const Uniform<glm::vec3> &uniform, const glm::vec3 &v) const {
+    glUniform3fv(uniform.get_location(), 1, glm::value_ptr(v));
+}
+
+void Program::Usage::set_uniform(const Uniform<GLint> &uniform, GLint x) const {
+    glUniform1i(uniform.get_location(), x);
+}
+
+void Program::Usage::set_uniform(const Uniform<GLfloat> &uniform, GLfloat x) const {
+    glUniform1f(uniform.get_location(), x);
 }
 
 Program::Program()
-    : id(glCreateProgram())
+    : id(glCreateProgram()),
+      linking(false)
 {
     if (id == 0) {
         throw Exception("Can't create program object");
@@ -46,6 +70,7 @@ Program::Program()
 }
 
 Program::~Program() {
+    GLState::get().forget_program(id);
     glDeleteProgram(id);
 }
 
@@ -53,12 +78,84 @@ void Program::bind(GLuint index, const GLchar *name) const {
     glBindAttribLocation(id, index, name);
 }
 
-void Program::attach(const Shader &shader) const {
+void Program::attach(Shader &&shader) {
     glAttachShader(id, shader.get_id());
+    shaders.push_back(std::move(shader));
 }
 
-void Program::link() const {
+void Program::link() {
     glLinkProgram(id);
+    linking = true;
+}
+
+std::optional<bool> Program::is_ready() const {
+    if (!linking) {
+        return true;
+    }
+    if (!GLState::get().has_parallel_shader_compile()) {
+        return std::nullopt;
+    }
+    GLint done;
+    glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+Program::Usage Program::use() const {
+    finish();
+    return Usage(*this);
+}
+
+GLint Program::get_uniform_location(const char *name) const {
+    finish();
+    const auto i = locations.find(name);
+    return i != locations.end() ? i->second : -1;
+}
+
+void Program::set_retrievable() const {
+    glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+std::vector<GLubyte> Program::get_binary(GLenum &format) const {
+    finish();
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    std::vector<GLubyte> binary(length);
+    if (length > 0) {
+        glGetProgramBinary(id, length, nullptr, &format, binary.data());
+    }
+    return binary;
+}
+
+bool Program::load_binary(GLenum format, const void *binary, GLsizei length) {
+    glProgramBinary(id, format, binary, length);
+    linking = false;
+    GLint status;
+    glGetProgramiv(id, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        return false;
+    }
+    find_uniforms();
+    return true;
+}
+
+void Program::bind_uniform_block(const char *name, GLuint binding) const {
+    finish();
+    const GLuint index = glGetUniformBlockIndex(id, name);
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id, index, binding);
+    }
+}
+
+// The compile errors of the shaders are reported first, as they're what
+// makes linking fail. A program that failed stays unfinished, so every use
+// of it reports the error again instead of using the unlinked program.
+void Program::finish() const {
+    if (!linking) {
+        return;
+    }
+    for (const Shader &shader : shaders) {
+        shader.check();
+    }
 
     GLint status;
     glGetProgramiv(id, GL_LINK_STATUS, &status);
@@ -69,8 +166,37 @@ void Program::link() const {
         glGetProgramInfoLog(id, length, NULL, buffer.data());
         throw Exception(buffer.data());
     }
+
+    linking = false;
+    for (const Shader &shader : shaders) {
+        glDetachShader(id, shader.get_id());
+    }
+    shaders.clear();
+    find_uniforms();
 }
 
-Program::Usage Program::use() const {
-    return Usage(*this);
+// Arrays are reported as their first element, which can be set by the name
+// of the array as well. Uniforms in blocks have no location.
+void Program::find_uniforms() const {
+    locations.clear();
+    GLint count;
+    GLint max_length;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> name(max_length);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(id, i, max_length, &length, &size, &type, name.data());
+        const GLint location = glGetUniformLocation(id, name.data());
+        if (location == -1) {
+            continue;
+        }
+        std::string uniform(name.data(), length);
+        locations[uniform] = location;
+        if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+            locations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+    }
 }
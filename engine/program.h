@@ -5,8 +5,18 @@
 #include <GL/glew.h>
 #include <glm/mat4x4.hpp>
 
+#include <map>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
+// Linking is only submitted by link(), so the driver can compile and link
+// all programs while the application goes on loading. The shaders and the
+// link are checked, and the locations of the active uniforms looked up, when
+// the program is first used, which waits for the driver if it isn't done.
+// Uniforms set every frame should be resolved into handles with
+// get_uniform(), which skips the lookup by name.
 class Program {
 public:
     class Exception : public std::runtime_error {
@@ -14,6 +24,21 @@ public:
         Exception(const char *message);
     };
 
+    // The location of a uniform of type T, or -1 if the program has no such
+    // uniform, which GL ignores.
+    template <typename T>
+    class Uniform {
+    public:
+        Uniform() : location(-1) { }
+
+        GLint get_location() const { return location; }
+    private:
+        friend class Program;
+        explicit Uniform(GLint location) : location(location) { }
+
+        GLint location;
+    };
+
     class Usage {
     public:
         Usage(const Program &program);
@@ -24,6 +49,11 @@ public:
         void set_uniform(const char *name, const glm::vec3 &v) const;
         void set_uniform(const char *name, GLint x) const;
         void set_uniform(const char *name, GLfloat x) const;
+        void set_uniform(const Uniform<glm::mat4x4> &uniform, const glm::mat4x4 &m, bool transpose = false) const;
+        void set_uniform(const Uniform<glm::mat2> &uniform, const glm::mat2 &m, bool transpose = false) const;
+        void set_uniform(const Uniform<glm::vec3> &uniform, const glm::vec3 &v) const;
+        void set_uniform(const Uniform<GLint> &uniform, GLint x) const;
+        void set_uniform(const Uniform<GLfloat> &uniform, GLfloat x) const;
 
         Usage(Usage &&) = delete;
         Usage(const Usage &) = delete;
@@ -37,12 +67,39 @@ public:
     ~Program();
 
     void bind(GLuint index, const GLchar *name) const;
-    void attach(const Shader &) const;
-    void link() const;
+    void attach(Shader &&shader);
+    void link();
+    // Whether the driver is done linking, so using the program won't wait,
+    // or nothing if the driver can't tell without waiting, which takes
+    // GL_KHR_parallel_shader_compile.
+    std::optional<bool> is_ready() const;
     Usage use() const;
 
+    // Asks the driver to keep the binary of the program, which has to be
+    // done before linking it.
+    void set_retrievable() const;
+    // Returns the binary of the linked program and its format, or nothing if
+    // the driver didn't keep it.
+    std::vector<GLubyte> get_binary(GLenum &format) const;
+    // Links the program from a binary of get_binary(), and returns whether
+    // the driver took it.
+    bool load_binary(GLenum format, const void *binary, GLsizei length);
+
+    GLint get_uniform_location(const char *name) const;
+    template <typename T>
+    Uniform<T> get_uniform(const char *name) const { return Uniform<T>(get_uniform_location(name)); }
+    // Binds the uniform block of the given name to a binding point of
+    // GL_UNIFORM_BUFFER, if the program has it.
+    void bind_uniform_block(const char *name, GLuint binding) const;
+
     Program(const Program &) = delete;
     Program &operator = (const Program &) = delete;
 private:
     GLuint id;
+    mutable std::vector<Shader> shaders;
+    mutable bool linking;
+    mutable std::map<std::string, GLint> locations;
+
+    void finish() const;
+    void find_uniforms() const;
 };
@@ -0,0 +1,145 @@
+#include "programcache.h"
+
+#include "mappedfile.h"
+#include "program.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = { 'V', 'P', 'B', 'C' };
+const Uint32 VERSION = 1;
+const Uint64 PRIME = 0x100000001b3ull;
+const Uint64 OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+struct Header {
+    char magic[4];
+    Uint32 version;
+    Uint64 key;
+    Uint64 checksum;
+    Uint32 format;
+    Uint32 length;
+};
+
+Uint64 hash(Uint64 hash, const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * PRIME;
+    }
+    return hash;
+}
+
+// Hashes a string along with its terminator, so the parts can't run into
+// each other.
+Uint64 hash(Uint64 value, const char *string) {
+    if (string == nullptr) {
+        string = "";
+    }
+    return hash(value, string, strlen(string) + 1);
+}
+
+}
+
+bool ProgramCache::is_supported() {
+    if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+}
+
+ProgramCache::ProgramCache(const std::string &directory)
+  : directory(directory),
+    driver(OFFSET_BASIS),
+    num_loaded(0),
+    num_missed(0)
+{
+    for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        driver = hash(driver, reinterpret_cast<const char *>(glGetString(name)));
+    }
+}
+
+Uint64 ProgramCache::get_key(const std::vector<std::string> &parts) const {
+    Uint64 key = driver;
+    for (const std::string &part : parts) {
+        key = hash(key, part.c_str());
+    }
+    return key;
+}
+
+bool ProgramCache::load(Program &program, Uint64 key) {
+    try {
+        const MappedFile file(get_filename(key));
+        const Header *header = static_cast<const Header *>(file.get_data());
+        if (file.get_size() < sizeof(Header) ||
+            memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+            header->key != key || file.get_size() < sizeof(Header) + header->length ||
+            hash(OFFSET_BASIS, header + 1, header->length) != header->checksum ||
+            !program.load_binary(header->format, header + 1, header->length))
+        {
+            ++num_missed;
+            return false;
+        }
+    } catch (const std::runtime_error &) {
+        ++num_missed;
+        return false;
+    }
+    ++num_loaded;
+    return true;
+}
+
+void ProgramCache::store(const Program &program, Uint64 key) {
+    pending.emplace_back(&program, key);
+}
+
+void ProgramCache::flush() {
+    const auto programs = std::move(pending);
+    pending.clear();
+    std::string errors;
+    for (const auto &[program, key] : programs) {
+        try {
+            write(*program, key);
+        } catch (const std::runtime_error &e) {
+            errors += (errors.empty() ? "" : "\n") + std::string(e.what());
+        }
+    }
+    if (!errors.empty()) {
+        throw std::runtime_error(errors);
+    }
+}
+
+void ProgramCache::write(const Program &program, Uint64 key) const {
+    GLenum format;
+    const std::vector<GLubyte> binary = program.get_binary(format);
+    if (binary.empty()) {
+        return;
+    }
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = key;
+    header.checksum = hash(OFFSET_BASIS, binary.data(), binary.size());
+    header.format = format;
+    header.length = static_cast<Uint32>(binary.size());
+
+    const std::string filename = get_filename(key);
+    std::ofstream output(filename, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("Can't write " + filename);
+    }
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(binary.data()), binary.size());
+    if (!output) {
+        throw std::runtime_error("Can't write " + filename);
+    }
+}
+
+std::string ProgramCache::get_filename(Uint64 key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.program", static_cast<unsigned long long>(key));
+    return directory + name;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <SDL.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Program;
+
+// Linked programs stored with glGetProgramBinary() in a directory, one file
+// per program. A program is found by a key hashed from everything it was
+// built from, along with the renderer and version of the driver, since a
+// binary is only valid for the driver that made it. A file that doesn't
+// match its key or is truncated, and a binary the driver rejects, count as
+// missing, so the program is built from source and stored again.
+class ProgramCache {
+public:
+    static bool is_supported();
+
+    // The directory ends with a separator, as the ones of SDL_GetPrefPath()
+    // do.
+    explicit ProgramCache(const std::string &directory);
+
+    // The key of a program built from the given parts, such as the sources
+    // of its shaders and the names of its attributes.
+    Uint64 get_key(const std::vector<std::string> &parts) const;
+
+    // Loads the program stored under key into program, and returns whether
+    // it's linked.
+    bool load(Program &program, Uint64 key);
+    // Stores a program linked after Program::set_retrievable() at the next
+    // flush(), so it isn't waited for before it's used. The program has to
+    // live until then.
+    void store(const Program &program, Uint64 key);
+    // Writes the stored programs. One that can't be written doesn't keep the
+    // others from being written, and the errors of all of them are reported
+    // together afterwards.
+    void flush();
+
+    size_t get_num_loaded() const { return num_loaded; }
+    size_t get_num_missed() const { return num_missed; }
+private:
+    std::string directory;
+    Uint64 driver;
+    size_t num_loaded;
+    size_t num_missed;
+    std::vector<std::pair<const Program *, Uint64>> pending;
+
+    std::string get_filename(Uint64 key) const;
+    void write(const Program &program, Uint64 key) const;
+};
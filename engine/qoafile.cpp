@@ -0,0 +1,275 @@
+#include "qoafile.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const size_t SLICE_FRAMES = 20;
+const size_t SLICES_PER_BLOCK = 256;
+const size_t HEADER_SIZE = 8;
+const Uint32 MAGIC = 0x716f6166;
+
+const int SCALEFACTORS[16] = { 1, 7, 21, 45, 84, 138, 211, 304, 421, 562, 731, 928, 1157, 1419, 1715, 2048 };
+const int QUANTIZED[17] = { 7, 7, 7, 5, 5, 3, 3, 1, 0, 0, 2, 2, 4, 4, 6, 6, 6 };
+const float DEQUANTIZED[8] = { 0.75f, -0.75f, 2.5f, -2.5f, 4.5f, -4.5f, 7.0f, -7.0f };
+
+struct Tables {
+    int reciprocal[16];
+    int dequantized[16][8];
+
+    Tables() {
+        for (int s = 0; s < 16; ++s) {
+            reciprocal[s] = ((1 << 16) + SCALEFACTORS[s] - 1) / SCALEFACTORS[s];
+            for (int q = 0; q < 8; ++q) {
+                dequantized[s][q] = static_cast<int>(std::lround(DEQUANTIZED[q] * SCALEFACTORS[s]));
+            }
+        }
+    }
+};
+
+const Tables tables;
+
+struct LMS {
+    int history[4];
+    int weights[4];
+
+    int predict() const {
+        int prediction = 0;
+        for (int i = 0; i < 4; ++i) {
+            prediction += weights[i] * history[i];
+        }
+        return prediction >> 13;
+    }
+
+    void update(int sample, int residual) {
+        const int delta = residual >> 4;
+        for (int i = 0; i < 4; ++i) {
+            weights[i] += history[i] < 0 ? -delta : delta;
+        }
+        history[0] = history[1];
+        history[1] = history[2];
+        history[2] = history[3];
+        history[3] = sample;
+    }
+};
+
+int clamp_s16(int value) {
+    return std::min(32767, std::max(-32768, value));
+}
+
+int divide(int value, int scalefactor) {
+    const int n = (value * tables.reciprocal[scalefactor] + (1 << 15)) >> 16;
+    return n + ((value > 0) - (value < 0)) - ((n > 0) - (n < 0));
+}
+
+Uint64 read_u64(const Uint8 *data) {
+    Uint64 value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+void write_u64(std::vector<Uint8> &out, Uint64 value) {
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<Uint8>(value >> (8 * i)));
+    }
+}
+
+size_t get_block_size(int channels, size_t frames) {
+    const size_t slices = (frames + SLICE_FRAMES - 1) / SLICE_FRAMES;
+    return 8 + channels * 16 + slices * channels * 8;
+}
+
+}
+
+void QOAFile::write(const std::string &filename, const Sint16 *samples, int channels, int freq, size_t frames) {
+    if (channels < 1 || channels > MAX_CHANNELS || freq < 1 || freq > 0xffffff || frames > std::numeric_limits<Uint32>::max()) {
+        throw std::runtime_error("Can't encode this audio as QOA");
+    }
+
+    std::vector<LMS> lms(channels);
+    for (LMS &state : lms) {
+        state = { { 0, 0, 0, 0 }, { 0, 0, -(1 << 13), 1 << 14 } };
+    }
+    std::vector<int> previous_scalefactor(channels, 0);
+
+    std::vector<Uint8> out;
+    write_u64(out, (static_cast<Uint64>(MAGIC) << 32) | frames);
+    for (size_t start = 0; start < frames; start += BLOCK_FRAMES) {
+        const size_t count = std::min(BLOCK_FRAMES, frames - start);
+        const Sint16 *block = samples + start * channels;
+        write_u64(out, (static_cast<Uint64>(channels) << 56) | (static_cast<Uint64>(freq) << 32)
+                     | (static_cast<Uint64>(count) << 16) | get_block_size(channels, count));
+
+        // The state is stored with 16 bits per value; the encoder continues
+        // from the truncated state, so that it predicts like the decoder.
+        for (LMS &state : lms) {
+            Uint64 history = 0;
+            Uint64 weights = 0;
+            for (int i = 0; i < 4; ++i) {
+                state.history[i] = static_cast<Sint16>(state.history[i]);
+                state.weights[i] = static_cast<Sint16>(state.weights[i]);
+                history = (history << 16) | static_cast<Uint16>(state.history[i]);
+                weights = (weights << 16) | static_cast<Uint16>(state.weights[i]);
+            }
+            write_u64(out, history);
+            write_u64(out, weights);
+        }
+
+        for (size_t slice_start = 0; slice_start < count; slice_start += SLICE_FRAMES) {
+            const size_t slice_frames = std::min(SLICE_FRAMES, count - slice_start);
+            for (int c = 0; c < channels; ++c) {
+                Uint64 best_error = std::numeric_limits<Uint64>::max();
+                Uint64 best_slice = 0;
+                LMS best_lms = lms[c];
+                int best_scalefactor = 0;
+                for (int k = 0; k < 16; ++k) {
+                    const int scalefactor = (k + previous_scalefactor[c]) % 16;
+                    LMS state = lms[c];
+                    Uint64 slice = scalefactor;
+                    Uint64 error = 0;
+                    for (size_t i = slice_start; i < slice_start + slice_frames; ++i) {
+                        const int sample = block[i * channels + c];
+                        const int predicted = state.predict();
+                        const int residual = sample - predicted;
+                        const int scaled = std::min(8, std::max(-8, divide(residual, scalefactor)));
+                        const int quantized = QUANTIZED[scaled + 8];
+                        const int dequantized = tables.dequantized[scalefactor][quantized];
+                        const int reconstructed = clamp_s16(predicted + dequantized);
+                        const Sint64 difference = sample - reconstructed;
+                        error += static_cast<Uint64>(difference * difference);
+                        if (error > best_error) {
+                            break;
+                        }
+                        state.update(reconstructed, dequantized);
+                        slice = (slice << 3) | static_cast<Uint64>(quantized);
+                    }
+                    if (error < best_error) {
+                        best_error = error;
+                        best_slice = slice;
+                        best_lms = state;
+                        best_scalefactor = scalefactor;
+                    }
+                }
+                previous_scalefactor[c] = best_scalefactor;
+                lms[c] = best_lms;
+                best_slice <<= (SLICE_FRAMES - slice_frames) * 3;
+                write_u64(out, best_slice);
+            }
+        }
+    }
+
+    std::ofstream output(filename, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(out.data()), out.size());
+    if (!output) {
+        throw std::runtime_error("Can't write " + filename);
+    }
+}
+
+QOAFile::QOAFile(const std::string &filename)
+  : filename(filename),
+    file(filename)
+{
+    const Uint8 *data = static_cast<const Uint8 *>(file.get_data());
+    if (file.get_size() < HEADER_SIZE + 8 || (read_u64(data) >> 32) != MAGIC) {
+        throw std::runtime_error(filename + " is not a QOA file");
+    }
+    length = static_cast<size_t>(read_u64(data) & 0xffffffff);
+    const Uint64 block_header = read_u64(data + HEADER_SIZE);
+    channels = static_cast<int>(block_header >> 56);
+    freq = static_cast<int>((block_header >> 32) & 0xffffff);
+    if (channels == 0 || channels > MAX_CHANNELS || freq == 0 || length == 0) {
+        throw std::runtime_error(filename + " is not a QOA file");
+    }
+    block_size = get_block_size(channels, BLOCK_FRAMES);
+    const size_t last = length - (get_num_blocks() - 1) * BLOCK_FRAMES;
+    if (file.get_size() < HEADER_SIZE + (get_num_blocks() - 1) * block_size + get_block_size(channels, last)) {
+        throw std::runtime_error("QOA file " + filename + " is truncated");
+    }
+}
+
+SDL_AudioSpec QOAFile::get_spec() const {
+    SDL_AudioSpec spec = {};
+    spec.freq = freq;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = static_cast<Uint8>(channels);
+    spec.samples = 4096;
+    return spec;
+}
+
+// Blocks all have the same size except for the last one, so the offset of a
+// block follows from its index without a seek table. Only the first header
+// is checked when the file is opened, so each block is checked against the
+// layout that follows from the length before it's decoded.
+size_t QOAFile::decode_block(size_t block, Sint16 *out) const {
+    if (block >= get_num_blocks()) {
+        return 0;
+    }
+    const size_t offset = HEADER_SIZE + block * block_size;
+    const Uint8 *data = static_cast<const Uint8 *>(file.get_data()) + offset;
+    const Uint64 header = read_u64(data);
+    const size_t frames = static_cast<size_t>((header >> 16) & 0xffff);
+    const size_t expected = block + 1 < get_num_blocks() ? BLOCK_FRAMES : length - block * BLOCK_FRAMES;
+    if (static_cast<int>(header >> 56) != channels || frames > BLOCK_FRAMES || frames != expected) {
+        throw std::runtime_error(filename + " is not a QOA file");
+    }
+    if (file.get_size() < offset + get_block_size(channels, frames)) {
+        throw std::runtime_error("QOA file " + filename + " is truncated");
+    }
+    data += 8;
+
+    std::array<LMS, 255> lms;
+    for (int c = 0; c < channels; ++c) {
+        Uint64 history = read_u64(data);
+        Uint64 weights = read_u64(data + 8);
+        data += 16;
+        for (int i = 3; i >= 0; --i) {
+            lms[c].history[i] = static_cast<Sint16>(history & 0xffff);
+            lms[c].weights[i] = static_cast<Sint16>(weights & 0xffff);
+            history >>= 16;
+            weights >>= 16;
+        }
+    }
+
+    for (size_t slice_start = 0; slice_start < frames; slice_start += SLICE_FRAMES) {
+        const size_t slice_end = std::min(frames, slice_start + SLICE_FRAMES);
+        for (int c = 0; c < channels; ++c) {
+            LMS &state = lms[c];
+            Uint64 slice = read_u64(data);
+            data += 8;
+            const int *dequantized = tables.dequantized[slice >> 60];
+            slice <<= 4;
+            for (size_t i = slice_start; i < slice_end; ++i) {
+                const int predicted = state.predict();
+                const int residual = dequantized[slice >> 61];
+                const int reconstructed = clamp_s16(predicted + residual);
+                out[i * channels + c] = static_cast<Sint16>(reconstructed);
+                state.update(reconstructed, residual);
+                slice <<= 3;
+            }
+        }
+    }
+    return frames;
+}
+
+std::vector<float> QOAFile::get_mono_samples() const {
+    std::vector<float> result(length);
+    std::vector<Sint16> block(BLOCK_FRAMES * channels);
+    for (size_t b = 0; b < get_num_blocks(); ++b) {
+        const size_t frames = decode_block(b, block.data());
+        for (size_t i = 0; i < frames; ++i) {
+            int sum = 0;
+            for (int c = 0; c < channels; ++c) {
+                sum += block[i * channels + c];
+            }
+            result[b * BLOCK_FRAMES + i] = static_cast<float>(sum) / (32768.0f * static_cast<float>(channels));
+        }
+    }
+    return result;
+}
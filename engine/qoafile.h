@@ -0,0 +1,41 @@
+#pragma once
+
+#include "mappedfile.h"
+
+#include <SDL.h>
+
+#include <string>
+#include <vector>
+
+// Lossy 16 bit audio in the QOA layout: blocks of 5120 frames, each
+// starting with the predictor state of every channel, so any block can be
+// decoded on its own.
+class QOAFile {
+public:
+    static const size_t BLOCK_FRAMES = 5120;
+    // The limit of the format, which keeps the size of a full block within
+    // the 16 bits of its header.
+    static const int MAX_CHANNELS = 8;
+
+    static void write(const std::string &filename, const Sint16 *samples, int channels, int freq, size_t frames);
+
+    explicit QOAFile(const std::string &filename);
+
+    SDL_AudioSpec get_spec() const;
+    int get_channels() const { return channels; }
+    int get_frequency() const { return freq; }
+    size_t get_length() const { return length; }
+    size_t get_num_blocks() const { return (length + BLOCK_FRAMES - 1) / BLOCK_FRAMES; }
+    size_t get_size() const { return file.get_size(); }
+
+    size_t decode_block(size_t block, Sint16 *out) const;
+    std::vector<float> get_mono_samples() const;
+
+private:
+    std::string filename;
+    MappedFile file;
+    int channels;
+    int freq;
+    size_t length;
+    size_t block_size;
+};
@@ -0,0 +1,123 @@
+#include "qoasource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const size_t NO_BLOCK = static_cast<size_t>(-1);
+
+}
+
+QOASource::QOASource(std::shared_ptr<const QOAFile> file, const SDL_AudioSpec &spec, size_t blocks_ahead)
+  : file(std::move(file)),
+    channels(spec.channels),
+    decoded(QOAFile::BLOCK_FRAMES * spec.channels),
+    current_decoded(QOAFile::BLOCK_FRAMES * spec.channels),
+    current(QOAFile::BLOCK_FRAMES * spec.channels),
+    current_block(NO_BLOCK),
+    current_frames(0),
+    read_block(0),
+    misses(0),
+    quit(false)
+{
+    if (this->file->get_frequency() != spec.freq || this->file->get_channels() != spec.channels) {
+        throw std::runtime_error("QOA file doesn't match the audio device");
+    }
+    for (size_t i = 0; i < blocks_ahead + 1; ++i) {
+        auto slot = std::make_unique<Slot>();
+        slot->block.store(NO_BLOCK);
+        slot->samples.resize(QOAFile::BLOCK_FRAMES * channels);
+        slots.push_back(std::move(slot));
+    }
+    worker = std::thread(&QOASource::run, this);
+}
+
+QOASource::~QOASource() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit.store(true);
+    }
+    condition.notify_one();
+    worker.join();
+}
+
+size_t QOASource::get_resident_size() const {
+    const size_t samples = QOAFile::BLOCK_FRAMES * channels;
+    return (slots.size() + 1) * samples * sizeof(float) + 2 * samples * sizeof(Sint16);
+}
+
+// Runs on the worker and the audio thread, where an exception can't be
+// handled, so a corrupt block plays as silence instead.
+size_t QOASource::decode(size_t block, Sint16 *scratch, float *out) const {
+    size_t frames;
+    try {
+        frames = file->decode_block(block, scratch);
+    } catch (const std::runtime_error &) {
+        std::fill(out, out + QOAFile::BLOCK_FRAMES * channels, 0.0f);
+        return 0;
+    }
+    for (size_t i = 0; i < frames * channels; ++i) {
+        out[i] = static_cast<float>(scratch[i]) * (1.0f / 32768.0f);
+    }
+    return frames;
+}
+
+void QOASource::load(size_t block) {
+    current_block = block;
+    const size_t last = file->get_num_blocks() - 1;
+    current_frames = block < last ? QOAFile::BLOCK_FRAMES : file->get_length() - last * QOAFile::BLOCK_FRAMES;
+
+    Slot &slot = *slots[block % slots.size()];
+    bool hit = false;
+    if (slot.block.load(std::memory_order_acquire) == block) {
+        memcpy(current.data(), slot.samples.data(), current_frames * channels * sizeof(float));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        hit = slot.block.load(std::memory_order_relaxed) == block;
+    }
+    if (!hit) {
+        decode(block, current_decoded.data(), current.data());
+        misses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    read_block.store(block, std::memory_order_release);
+    condition.notify_one();
+}
+
+void QOASource::read(size_t position, float *out, size_t frames) {
+    size_t done = 0;
+    while (done < frames && position + done < file->get_length()) {
+        const size_t block = (position + done) / QOAFile::BLOCK_FRAMES;
+        if (block != current_block) {
+            load(block);
+        }
+        const size_t offset = position + done - block * QOAFile::BLOCK_FRAMES;
+        const size_t count = std::min(frames - done, current_frames - offset);
+        memcpy(out + done * channels, current.data() + offset * channels, count * channels * sizeof(float));
+        done += count;
+    }
+    std::fill(out + done * channels, out + frames * channels, 0.0f);
+}
+
+void QOASource::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!quit.load()) {
+        lock.unlock();
+        const size_t first = read_block.load(std::memory_order_acquire) + 1;
+        const size_t end = std::min(first + slots.size() - 1, file->get_num_blocks());
+        for (size_t block = first; block < end && !quit.load(std::memory_order_relaxed); ++block) {
+            Slot &slot = *slots[block % slots.size()];
+            if (slot.block.load(std::memory_order_relaxed) == block) {
+                continue;
+            }
+            slot.block.store(NO_BLOCK, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            decode(block, decoded.data(), slot.samples.data());
+            slot.block.store(block, std::memory_order_release);
+        }
+        lock.lock();
+        condition.wait_for(lock, std::chrono::milliseconds(5));
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "mixer.h"
+#include "qoafile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Decodes the blocks following the one being played on a worker thread, so
+// the audio callback only copies samples. A block that is not ready, e.g.
+// right after a seek, is decoded in the callback instead.
+class QOASource : public Mixer::Source {
+public:
+    QOASource(std::shared_ptr<const QOAFile> file, const SDL_AudioSpec &spec, size_t blocks_ahead = 4);
+    ~QOASource();
+
+    size_t get_length() const override { return file->get_length(); }
+    void read(size_t position, float *out, size_t frames) override;
+
+    size_t get_misses() const { return misses.load(std::memory_order_relaxed); }
+    size_t get_resident_size() const;
+
+    QOASource(const QOASource &) = delete;
+    QOASource &operator = (const QOASource &) = delete;
+private:
+    struct Slot {
+        std::atomic<size_t> block;
+        std::vector<float> samples;
+    };
+
+    std::shared_ptr<const QOAFile> file;
+    int channels;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<Sint16> decoded;
+
+    std::vector<Sint16> current_decoded;
+    std::vector<float> current;
+    size_t current_block;
+    size_t current_frames;
+    std::atomic<size_t> read_block;
+    std::atomic<size_t> misses;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<bool> quit;
+    std::thread worker;
+
+    size_t decode(size_t block, Sint16 *scratch, float *out) const;
+    void load(size_t block);
+    void run();
+};
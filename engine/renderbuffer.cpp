@@ -1,13 +1,15 @@
 #include "renderbuffer.h"
 
+#include "glstate.h"
+
 Renderbuffer::Binding::Binding(GLenum target, const Renderbuffer &renderbuffer)
   : target(target)
 {
-    glBindRenderbuffer(target, renderbuffer.id);
+    GLState::get().bind_renderbuffer(target, renderbuffer.id);
 }
 
 Renderbuffer::Binding::~Binding() {
-    glBindRenderbuffer(target, 0);
+    GLState::get().release_renderbuffer(target);
 }
 
 void Renderbuffer::Binding::storage(GLenum internalformat, GLsizei width, GLsizei height) const {
@@ -19,6 +21,7 @@ Renderbuffer::Renderbuffer() {
 }
 
 Renderbuffer::~Renderbuffer() {
+    GLState::get().forget_renderbuffer(id);
     glDeleteRenderbuffers(1, &id);
 }
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// Lock-free ring buffer for exactly one producer and one consumer thread.
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity)
+      : buffer(capacity),
+        mask(capacity - 1),
+        head(0),
+        tail(0)
+    {
+        if (capacity == 0 || (capacity & mask) != 0) {
+            throw std::runtime_error("Ring buffer capacity must be a power of two");
+        }
+    }
+
+    size_t get_capacity() const { return buffer.size(); }
+
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    size_t write(const T *data, size_t count) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+        count = std::min(count, buffer.size() - (h - t));
+        for (size_t i = 0; i < count; ++i) {
+            buffer[(h + i) & mask] = data[i];
+        }
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t read(T *data, size_t count) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t h = head.load(std::memory_order_acquire);
+        count = std::min(count, h - t);
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = buffer[(t + i) & mask];
+        }
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator = (const RingBuffer &) = delete;
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+};
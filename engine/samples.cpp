@@ -0,0 +1,125 @@
+#include "samples.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLES_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+template<typename T>
+void quantize(const float *samples, size_t count, float scale, float bias, Uint8 *out) {
+    const float low = static_cast<float>(std::numeric_limits<T>::min());
+    const float high = static_cast<float>(std::numeric_limits<T>::max());
+    for (size_t i = 0; i < count; ++i) {
+        const T x = static_cast<T>(std::clamp(std::nearbyint(samples[i] * scale + bias), low, high));
+        memcpy(out + i * sizeof(T), &x, sizeof(T));
+    }
+}
+
+}
+
+bool is_supported_format(SDL_AudioFormat format) {
+    switch (format) {
+    case AUDIO_U8:
+    case AUDIO_S8:
+    case AUDIO_S16SYS:
+    case AUDIO_S32SYS:
+    case AUDIO_F32SYS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t get_sample_size(SDL_AudioFormat format) {
+    return SDL_AUDIO_BITSIZE(format) >> 3;
+}
+
+void convert_to_float(const Uint8 *data, SDL_AudioFormat format, size_t count, float *out) {
+    switch (format) {
+    case AUDIO_U8:
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = (static_cast<float>(data[i]) - 128.0f) / 128.0f;
+        }
+        break;
+    case AUDIO_S8:
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<float>(static_cast<Sint8>(data[i])) / 128.0f;
+        }
+        break;
+    case AUDIO_S16SYS:
+        for (size_t i = 0; i < count; ++i) {
+            Sint16 x;
+            memcpy(&x, data + i * sizeof(x), sizeof(x));
+            out[i] = static_cast<float>(x) / 32768.0f;
+        }
+        break;
+    case AUDIO_S32SYS:
+        for (size_t i = 0; i < count; ++i) {
+            Sint32 x;
+            memcpy(&x, data + i * sizeof(x), sizeof(x));
+            out[i] = static_cast<float>(x) / 2147483648.0f;
+        }
+        break;
+    case AUDIO_F32SYS:
+        memcpy(out, data, count * sizeof(float));
+        break;
+    default:
+        memset(out, 0, count * sizeof(float));
+        break;
+    }
+}
+
+void convert_from_float(const float *samples, size_t count, SDL_AudioFormat format, Uint8 *out) {
+    switch (format) {
+    case AUDIO_U8:
+        quantize<Uint8>(samples, count, 128.0f, 128.0f, out);
+        break;
+    case AUDIO_S8:
+        quantize<Sint8>(samples, count, 128.0f, 0.0f, out);
+        break;
+    case AUDIO_S16SYS: {
+        size_t i = 0;
+#ifdef SAMPLES_SSE2
+        const __m128 scale = _mm_set1_ps(32768.0f);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i), scale));
+            const __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i + 4), scale));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * sizeof(Sint16)), _mm_packs_epi32(a, b));
+        }
+#endif
+        quantize<Sint16>(samples + i, count - i, 32768.0f, 0.0f, out + i * sizeof(Sint16));
+        break;
+    }
+    case AUDIO_S32SYS:
+        for (size_t i = 0; i < count; ++i) {
+            const double x = std::clamp(static_cast<double>(samples[i]) * 2147483648.0, -2147483648.0, 2147483647.0);
+            const Sint32 y = static_cast<Sint32>(std::nearbyint(x));
+            memcpy(out + i * sizeof(y), &y, sizeof(y));
+        }
+        break;
+    case AUDIO_F32SYS:
+        memcpy(out, samples, count * sizeof(float));
+        break;
+    default:
+        memset(out, 0, count * get_sample_size(format));
+        break;
+    }
+}
+
+void convert_to_mono(const float *samples, int channels, size_t frames, float *out) {
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            sum += samples[i * channels + c];
+        }
+        out[i] = sum * scale;
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstddef>
+
+bool is_supported_format(SDL_AudioFormat format);
+size_t get_sample_size(SDL_AudioFormat format);
+
+void convert_to_float(const Uint8 *data, SDL_AudioFormat format, size_t count, float *out);
+void convert_from_float(const float *samples, size_t count, SDL_AudioFormat format, Uint8 *out);
+void convert_to_mono(const float *samples, int channels, size_t frames, float *out);
@@ -15,7 +15,9 @@ Shader::Shader(GLenum type, const char *source)
     const GLint source_lengths[] = { static_cast<GLint>(strlen(source)) };
     glShaderSource(id, 1, sources, source_lengths);
     glCompileShader(id);
+}
 
+void Shader::check() const {
     GLint status;
     glGetShaderiv(id, GL_COMPILE_STATUS, &status);
     if (status == GL_FALSE) {
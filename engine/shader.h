@@ -4,6 +4,9 @@
 
 #include <stdexcept>
 
+// A shader is only submitted for compiling when it's created, which the
+// driver may do in the background. Its status is checked when a program it's
+// attached to is first used.
 class Shader {
 public:
     class Exception : public std::runtime_error {
@@ -11,6 +14,13 @@ public:
         Exception(const char *message);
     };
 
+    // A source specialised by the macro definitions in key, such as
+    // HORIZONTAL=1,RADIUS=4, as generated by convert_shader_variants.cmake.
+    struct Variant {
+        const char *key;
+        const char *source;
+    };
+
     explicit Shader(GLenum type, const char *source);
     ~Shader();
 
@@ -18,6 +28,8 @@ public:
     Shader &operator = (Shader &&shader);
 
     GLuint get_id() const { return id; }
+    // Waits for the compiler and throws its info log if it failed.
+    void check() const;
 
     Shader(const Shader &) = delete;
     Shader operator = (const Shader &) = delete;
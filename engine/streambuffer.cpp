@@ -0,0 +1,124 @@
+#include "streambuffer.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+const GLbitfield PERSISTENT_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+}
+
+bool StreamBuffer::is_supported(Mode mode) {
+    switch (mode) {
+    case Mode::PERSISTENT:
+        return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    case Mode::ORPHAN:
+    case Mode::SYNCHRONIZED:
+        return true;
+    }
+    return false;
+}
+
+StreamBuffer::Mode StreamBuffer::get_default_mode() {
+    return is_supported(Mode::PERSISTENT) ? Mode::PERSISTENT : Mode::ORPHAN;
+}
+
+StreamBuffer::StreamBuffer(GLsizeiptr region_size, Mode mode)
+  : region_size(region_size),
+    mode(mode),
+    persistent(nullptr),
+    fences{},
+    region(NUM_REGIONS - 1),
+    mapped(nullptr),
+    map_time(0)
+{
+    if (!is_supported(mode)) {
+        throw std::runtime_error("Persistently mapped buffers aren't supported");
+    }
+    if (mode == Mode::PERSISTENT) {
+        buffer.storage(region_size * NUM_REGIONS, nullptr, PERSISTENT_FLAGS);
+        persistent = static_cast<GLubyte *>(buffer.map_range(0, region_size * NUM_REGIONS, PERSISTENT_FLAGS));
+        if (persistent == nullptr) {
+            throw std::runtime_error("Can't map stream buffer");
+        }
+    } else {
+        buffer.data(region_size * NUM_REGIONS, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+    if (persistent != nullptr || mapped != nullptr) {
+        buffer.unmap();
+    }
+}
+
+void *StreamBuffer::map() {
+    if (mapped != nullptr) {
+        map_time = 0;
+        return mapped;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    region = (region + 1) % NUM_REGIONS;
+    const GLintptr offset = region * region_size;
+    if (mode == Mode::PERSISTENT) {
+        wait(region);
+        mapped = persistent + offset;
+    } else {
+        GLbitfield access = GL_MAP_WRITE_BIT;
+        if (mode == Mode::ORPHAN) {
+            if (region == 0) {
+                buffer.data(region_size * NUM_REGIONS, nullptr, GL_STREAM_DRAW);
+            }
+            access |= GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        }
+        mapped = buffer.map_range(offset, region_size, access);
+        if (mapped == nullptr) {
+            throw std::runtime_error("Can't map stream buffer");
+        }
+    }
+    map_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return mapped;
+}
+
+GLintptr StreamBuffer::unmap(GLsizeiptr size) {
+    if (size > region_size) {
+        throw std::runtime_error("Stream buffer region overflowed");
+    }
+    if (mapped != nullptr && mode != Mode::PERSISTENT) {
+        buffer.unmap();
+    }
+    mapped = nullptr;
+    return region * region_size;
+}
+
+void StreamBuffer::fence() {
+    if (mode != Mode::PERSISTENT) {
+        return;
+    }
+    if (fences[region] != nullptr) {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::wait(size_t region) {
+    GLsync &fence = fences[region];
+    if (fence == nullptr) {
+        return;
+    }
+    GLenum result;
+    do {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    fence = nullptr;
+    if (result == GL_WAIT_FAILED) {
+        throw std::runtime_error("Waiting for stream buffer region failed");
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "buffer.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// A buffer for data written anew every frame. It's split into regions used
+// in turn, so the CPU can fill one while the GPU still reads the others.
+//
+// PERSISTENT keeps the whole buffer mapped with GL_ARB_buffer_storage and
+// puts a fence behind the draws from each region, which is waited for
+// before the region is written again. ORPHAN gives the buffer new storage
+// whenever the first region comes around again and maps the regions
+// unsynchronized, leaving it to the driver to keep the old storage alive.
+// SYNCHRONIZED maps the regions plainly, so the driver waits for the GPU to
+// be done with the buffer, as it would for glBufferSubData.
+//
+// The buffer is mapped on its own rather than through a binding, so it can
+// stay bound to its target, or to a vertex array, while it's written.
+class StreamBuffer {
+public:
+    enum class Mode {
+        PERSISTENT,
+        ORPHAN,
+        SYNCHRONIZED
+    };
+
+    static const size_t NUM_REGIONS = 3;
+
+    static bool is_supported(Mode mode);
+    // The best supported mode.
+    static Mode get_default_mode();
+
+    explicit StreamBuffer(GLsizeiptr region_size, Mode mode = get_default_mode());
+    ~StreamBuffer();
+
+    // Returns the memory of the next region, which may only be written. If
+    // the current region is still mapped, it's returned again.
+    void *map();
+    // Ends writing size bytes to the region and returns its offset in the
+    // buffer.
+    GLintptr unmap(GLsizeiptr size);
+    // Marks the region last unmapped as used by the commands issued so far.
+    void fence();
+
+    Mode get_mode() const { return mode; }
+    const Buffer &get_buffer() const { return buffer; }
+    GLsizeiptr get_region_size() const { return region_size; }
+    // The nanoseconds the last map() took, including any wait for the GPU.
+    GLuint64 get_map_time() const { return map_time; }
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator = (const StreamBuffer &) = delete;
+private:
+    GLsizeiptr region_size;
+    Mode mode;
+    Buffer buffer;
+    GLubyte *persistent;
+    GLsync fences[NUM_REGIONS];
+    size_t region;
+    void *mapped;
+    GLuint64 map_time;
+
+    void wait(size_t region);
+};
@@ -1,15 +1,17 @@
 #include "texture.h"
 
+#include "glstate.h"
+
+// The unit is made active again before every call on the binding, as another
+// binding may have changed it since.
 Texture::Binding::Binding(GLenum texture_unit, GLenum target, const Texture &texture)
   : texture_unit(texture_unit), target(target)
 {
-    glActiveTexture(texture_unit);
-    glBindTexture(target, texture.id);
+    GLState::get().bind_texture(texture_unit, target, texture.id);
 }
 
 Texture::Binding::~Binding() {
-    glActiveTexture(texture_unit);
-    glBindTexture(target, 0);
+    GLState::get().release_texture(texture_unit, target);
 }
 
 void Texture::Binding::image_2d(GLint level, GLint internalformat,
@@ -17,26 +19,44 @@ void Texture::Binding::image_2d(GLint level, GLint internalformat,
                                 GLenum format, GLenum type,
                                 const void *data) const
 {
+    GLState::get().activate_texture(texture_unit);
     glTexImage2D(target, level, internalformat, width, height, border,
                     format, type, data);
 }
 
 void Texture::Binding::set_parameter(GLenum pname, GLint param) const {
+    GLState::get().activate_texture(texture_unit);
     glTexParameteri(target, pname, param);
 }
 
 void Texture::Binding::generate_mipmap() const {
+    GLState::get().activate_texture(texture_unit);
     glGenerateMipmap(target);
 }
 
-Texture::Texture() {
-    glGenTextures(1, &id);
+Texture::Texture(GLenum target)
+  : target(target)
+{
+    if (GLState::get().has_direct_state_access()) {
+        glCreateTextures(target, 1, &id);
+    } else {
+        glGenTextures(1, &id);
+    }
 }
 
 Texture::~Texture() {
+    GLState::get().forget_texture(id);
     glDeleteTextures(1, &id);
 }
 
 Texture::Binding Texture::bind(GLenum texture_unit, GLenum target) const {
     return Binding(texture_unit, target, *this);
 }
+
+void Texture::set_parameter(GLenum pname, GLint param) const {
+    if (GLState::get().has_direct_state_access()) {
+        glTextureParameteri(id, pname, param);
+    } else {
+        bind(GL_TEXTURE0, target).set_parameter(pname, param);
+    }
+}
@@ -28,15 +28,21 @@ public:
         GLenum target;
     };
 
-    Texture();
+    // With direct state access the texture is created for target, so it may
+    // only be bound to that.
+    explicit Texture(GLenum target = GL_TEXTURE_2D);
     ~Texture();
 
     Binding bind(GLenum texture_unit, GLenum target) const;
+    // Sets a parameter without a binding where direct state access is
+    // available, and binds the texture to the first unit otherwise.
+    void set_parameter(GLenum pname, GLint param) const;
 
     GLuint get_id() const { return id; }
 
     Texture(const Texture &) = delete;
     Texture &operator = (const Texture &) = delete;
 private:
+    GLenum target;
     GLuint id;
 };
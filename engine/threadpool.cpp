@@ -0,0 +1,87 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(size_t num_threads)
+  : task(nullptr),
+    count(0),
+    next(0),
+    busy(0),
+    generation(0),
+    quit(false)
+{
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    start.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        next = 0;
+        busy = workers.size();
+        error = nullptr;
+        ++generation;
+    }
+    start.notify_all();
+    execute();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    this->task = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Iterations are handed out one at a time under the lock. Tasks are meant
+// to be coarse, so this isn't contended.
+void ThreadPool::execute() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (next < count) {
+        const size_t i = next++;
+        lock.unlock();
+        try {
+            (*task)(i);
+        } catch (...) {
+            lock.lock();
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+            continue;
+        }
+        lock.lock();
+    }
+}
+
+void ThreadPool::work() {
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) {
+                return;
+            }
+            seen = generation;
+        }
+        execute();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy;
+        }
+        done.notify_one();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the iterations of a loop on a fixed set of worker threads. The
+// calling thread takes part, so a pool of one thread has no workers and
+// runs everything inline.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    size_t get_num_threads() const { return workers.size() + 1; }
+
+    // Calls task(i) for every i below count and returns when all calls have
+    // finished. The first exception thrown by a task is rethrown here.
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator = (const ThreadPool &) = delete;
+private:
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    const std::function<void(size_t)> *task;
+    size_t count;
+    size_t next;
+    size_t busy;
+    size_t generation;
+    bool quit;
+    std::exception_ptr error;
+    std::vector<std::thread> workers;
+
+    void execute();
+    void work();
+};
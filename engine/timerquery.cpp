@@ -0,0 +1,41 @@
+#include "timerquery.h"
+
+TimerQuery::TimerQuery()
+  : next(0),
+    pending(0),
+    elapsed(0)
+{
+    glGenQueries(NUM_QUERIES, ids);
+}
+
+TimerQuery::~TimerQuery() {
+    glDeleteQueries(NUM_QUERIES, ids);
+}
+
+void TimerQuery::begin() {
+    if (pending == NUM_QUERIES) {
+        collect(true);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, ids[next]);
+}
+
+void TimerQuery::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    next = (next + 1) % NUM_QUERIES;
+    ++pending;
+    collect(false);
+}
+
+void TimerQuery::collect(bool wait) {
+    for (; pending > 0; --pending, wait = false) {
+        const GLuint id = ids[(next + NUM_QUERIES - pending) % NUM_QUERIES];
+        if (!wait) {
+            GLint available;
+            glGetQueryObjectiv(id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+        }
+        glGetQueryObjectui64v(id, GL_QUERY_RESULT, &elapsed);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// Measures the time the GPU spends on the commands between begin() and
+// end(). Results arrive some frames later, so several queries are used in
+// turn and the latest finished one is reported, which only blocks once all
+// of them are still pending.
+class TimerQuery {
+public:
+    TimerQuery();
+    ~TimerQuery();
+
+    void begin();
+    void end();
+
+    // Nanoseconds, or 0 while no measurement finished yet.
+    GLuint64 get_elapsed() const { return elapsed; }
+
+    TimerQuery(const TimerQuery &) = delete;
+    TimerQuery &operator = (const TimerQuery &) = delete;
+private:
+    static const size_t NUM_QUERIES = 4;
+
+    GLuint ids[NUM_QUERIES];
+    size_t next;
+    size_t pending;
+    GLuint64 elapsed;
+
+    void collect(bool wait);
+};
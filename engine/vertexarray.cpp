@@ -1,16 +1,17 @@
 #include "vertexarray.h"
 
 #include "buffer.h"
+#include "glstate.h"
 
 VertexArray::Binding::Binding(const VertexArray &vao)
   : bound(true)
 {
-    glBindVertexArray(vao.id);
+    GLState::get().bind_vertex_array(vao.id);
 }
 
 VertexArray::Binding::~Binding() {
     if (bound) {
-        glBindVertexArray(0);
+        GLState::get().release_vertex_array();
     }
 }
 
@@ -20,11 +21,24 @@ void VertexArray::Binding::enable_attribute(GLuint index) const {
     }
 }
 
+void VertexArray::Binding::attribute_divisor(GLuint index, GLuint divisor) const {
+    if (bound) {
+        glVertexAttribDivisor(index, divisor);
+    }
+}
+
+void VertexArray::Binding::element_buffer(const Buffer &buffer) const {
+    if (bound) {
+        GLState::get().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer.get_id());
+    }
+}
+
 VertexArray::VertexArray() {
     glGenVertexArrays(1, &id);
 }
 
 VertexArray::~VertexArray() {
+    GLState::get().forget_vertex_array(id);
     glDeleteVertexArrays(1, &id);
 }
 
@@ -4,6 +4,8 @@
 
 #include <optional>
 
+class Buffer;
+
 class VertexArray {
 public:
     class Binding {
@@ -12,6 +14,10 @@ public:
         ~Binding();
 
         void enable_attribute(GLuint index) const;
+        void attribute_divisor(GLuint index, GLuint divisor) const;
+        // Makes buffer the element array buffer of the vertex array, which
+        // it stays after the binding ends.
+        void element_buffer(const Buffer &buffer) const;
 
         Binding(Binding &&) = delete;
         Binding(const Binding &) = delete;
@@ -1,6 +1,8 @@
 #include "wave.h"
 
-#include <cassert>
+#include "samples.h"
+
+#include <cstring>
 #include <stdexcept>
 
 Wave::Wave(const std::string &filename) {
@@ -25,12 +27,45 @@ Uint32 Wave::get_length() const {
     return length;
 }
 
+Uint64 Wave::get_hash() const {
+    const Uint64 prime = 0x100000001b3ull;
+    Uint64 hash = 0xcbf29ce484222325ull;
+    const Uint64 header[] = { static_cast<Uint64>(spec.freq), spec.format, spec.channels, length };
+    for (const Uint64 word : header) {
+        hash = (hash ^ word) * prime;
+    }
+    Uint32 i = 0;
+    for (; i + sizeof(Uint64) <= length; i += sizeof(Uint64)) {
+        Uint64 word;
+        memcpy(&word, buffer + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < length; ++i) {
+        hash = (hash ^ buffer[i]) * prime;
+    }
+    return hash;
+}
+
 std::vector<Uint8> Wave::convert_to_spec(const SDL_AudioSpec &destination) const {
     SDL_AudioCVT cvt;
     SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, destination.format, destination.channels, destination.freq);
     cvt.len = length;
     std::vector<Uint8> result(cvt.len * cvt.len_mult);
+    memcpy(result.data(), buffer, length);
     cvt.buf = result.data();
-    assert(SDL_ConvertAudio(&cvt) == 0);
+    if (SDL_ConvertAudio(&cvt) != 0) {
+        throw std::runtime_error("Can't convert wave file");
+    }
+    result.resize(cvt.len_cvt);
+    return result;
+}
+
+std::vector<float> Wave::get_mono_samples() const {
+    SDL_AudioSpec f32 = spec;
+    f32.format = AUDIO_F32SYS;
+    const std::vector<Uint8> converted = convert_to_spec(f32);
+    const size_t frames = converted.size() / (sizeof(float) * spec.channels);
+    std::vector<float> result(frames);
+    convert_to_mono(reinterpret_cast<const float *>(converted.data()), spec.channels, frames, result.data());
     return result;
 }
@@ -16,8 +16,10 @@ public:
     const SDL_AudioSpec &get_spec() const;
     const Uint8 *get_buffer() const;
     Uint32 get_length() const;
+    Uint64 get_hash() const;
 
     std::vector<Uint8> convert_to_spec(const SDL_AudioSpec &destination) const;
+    std::vector<float> get_mono_samples() const;
 private:
     SDL_AudioSpec spec;
     Uint8 *buffer;
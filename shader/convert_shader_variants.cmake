@@ -0,0 +1,31 @@
+# Like convert_shader.cmake, but writes one source per variant given after
+# the header, each a list of macro definitions such as HORIZONTAL=1,RADIUS=4,
+# which are inserted after the #version line. The variants are listed with
+# their definitions as keys in ${SHADER_NAME}_variants.
+set(SHADER_NAME "${CMAKE_ARGV3}")
+set(SHADER "${CMAKE_ARGV4}")
+set(SHADER_HEADER "${CMAKE_ARGV5}")
+
+file(READ "${SHADER}" CONTENT)
+string(FIND "${CONTENT}" "\n" VERSION_END)
+string(SUBSTRING "${CONTENT}" 0 ${VERSION_END} VERSION)
+math(EXPR BODY_BEGIN "${VERSION_END} + 1")
+string(SUBSTRING "${CONTENT}" ${BODY_BEGIN} -1 BODY)
+
+set(HEADER "#pragma once\n\n#include <shader.h>\n\n")
+set(TABLE "")
+math(EXPR LAST "${CMAKE_ARGC} - 1")
+foreach(I RANGE 6 ${LAST})
+    set(KEY "${CMAKE_ARGV${I}}")
+    math(EXPR INDEX "${I} - 6")
+    string(REPLACE "," ";" DEFINES "${KEY}")
+    set(DEFINITIONS "")
+    foreach(DEFINE ${DEFINES})
+        string(REPLACE "=" " " DEFINE "${DEFINE}")
+        string(APPEND DEFINITIONS "#define ${DEFINE}\n")
+    endforeach()
+    string(APPEND HEADER "const char ${SHADER_NAME}_${INDEX}[] = R\"(\n${VERSION}\n${DEFINITIONS}${BODY})\";\n\n")
+    string(APPEND TABLE "    { \"${KEY}\", ${SHADER_NAME}_${INDEX} },\n")
+endforeach()
+string(APPEND HEADER "const Shader::Variant ${SHADER_NAME}_variants[] = {\n${TABLE}};\n")
+file(WRITE "${SHADER_HEADER}" "${HEADER}")
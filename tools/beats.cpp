@@ -0,0 +1,75 @@
+#include <beattracker.h>
+#include <featureextractor.h>
+#include <wave.h>
+
+#include <SDL.h>
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <song.wav> [meter] [output.json]\n";
+        return EXIT_FAILURE;
+    }
+    if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+        std::cerr << SDL_GetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const size_t frame_size = 2048;
+    const size_t hop_size = 512;
+    const unsigned int threads = std::thread::hardware_concurrency();
+    const std::string meter = argc > 2 ? argv[2] : "4/4";
+
+    try {
+        const int beats_per_measure = std::stoi(meter.substr(0, meter.find('/')));
+        const Wave wav(argv[1]);
+        const int freq = wav.get_spec().freq;
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<float> samples = wav.get_mono_samples();
+        const auto features = extract_features(samples, freq, frame_size, hop_size, threads);
+        const Beats beats = track_beats(features, static_cast<float>(freq) / hop_size, beats_per_measure, threads);
+        const auto end = std::chrono::steady_clock::now();
+
+        nlohmann::json result;
+        result["general"]["bpm"] = beats.bpm;
+        result["general"]["meter"] = meter;
+        result["general"]["offset"] = beats.offset;
+        result["confidence"]["tempo"] = beats.tempo_confidence;
+        result["confidence"]["beats"] = beats.beat_confidence;
+        result["confidence"]["downbeat"] = beats.downbeat_confidence;
+        result["beats"] = beats.times;
+
+        if (argc > 3) {
+            std::ofstream output(argv[3]);
+            if (!output) {
+                throw std::runtime_error(std::string("Can't write ") + argv[3]);
+            }
+            output << result.dump(4) << '\n';
+            output.close();
+            if (!output) {
+                throw std::runtime_error(std::string("Can't write ") + argv[3]);
+            }
+        } else {
+            nlohmann::json summary = result;
+            summary.erase("beats");
+            std::cout << summary.dump(4) << '\n';
+        }
+        std::cerr << "Tracked " << beats.times.size() << " beats in "
+                  << static_cast<double>(samples.size()) / freq << " s of audio within "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+#include <featurecache.h>
+#include <featureextractor.h>
+#include <wave.h>
+
+#include <SDL.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <song.wav> [threads]\n";
+        return EXIT_FAILURE;
+    }
+    if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+        std::cerr << SDL_GetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const size_t frame_size = 2048;
+    const size_t hop_size = 512;
+    unsigned int threads = std::thread::hardware_concurrency();
+
+    try {
+        if (argc > 2) {
+            threads = static_cast<unsigned int>(std::stoul(argv[2]));
+        }
+        const Wave wav(argv[1]);
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<float> samples = wav.get_mono_samples();
+        const auto features = extract_features(samples, wav.get_spec().freq, frame_size, hop_size, threads);
+        const auto end = std::chrono::steady_clock::now();
+
+        const std::string filename = FeatureCache::get_filename(argv[1]);
+        FeatureCache::write(filename, wav.get_hash(), wav.get_spec().freq, hop_size, features);
+
+        const double seconds = static_cast<double>(samples.size()) / wav.get_spec().freq;
+        std::cout << "Wrote " << features.size() << " frames for " << seconds << " s of audio to " << filename << '\n'
+                  << "Analysis took " << std::chrono::duration<double, std::milli>(end - start).count()
+                  << " ms on " << threads << " threads\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
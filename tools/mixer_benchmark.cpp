@@ -0,0 +1,71 @@
+#include <mixer.h>
+
+#include <SDL.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+class NoiseSource : public Mixer::Source {
+public:
+    NoiseSource(size_t length, int channels, unsigned int seed)
+      : channels(channels),
+        samples(length * channels)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(-0.1f, 0.1f);
+        for (float &x : samples) {
+            x = distribution(generator);
+        }
+    }
+
+    size_t get_length() const override { return samples.size() / channels; }
+
+    void read(size_t position, float *out, size_t frames) override {
+        std::copy(samples.begin() + position * channels, samples.begin() + (position + frames) * channels, out);
+    }
+
+private:
+    int channels;
+    std::vector<float> samples;
+};
+
+}
+
+int main() {
+    SDL_AudioSpec spec;
+    spec.freq = 44100;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = 2;
+    spec.samples = 1024;
+    spec.silence = 0;
+
+    const size_t length = 10 * spec.freq;
+    const int len = spec.samples * spec.channels * sizeof(Sint16);
+    const double budget = 1e6 * spec.samples / spec.freq;
+    std::vector<Uint8> buffer(len);
+
+    std::cout << "stems;us per callback;share of real-time budget\n";
+    for (size_t stems = 1; stems <= 32; stems *= 2) {
+        Mixer mixer(spec);
+        for (size_t i = 0; i < stems; ++i) {
+            mixer.add_source("stem" + std::to_string(i), std::make_unique<NoiseSource>(length, spec.channels, static_cast<unsigned int>(i)));
+            mixer.set_gain(i, 0.5f + 0.01f * i);
+        }
+
+        size_t callbacks = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (mixer.get_position() < mixer.get_length()) {
+            mixer.mix(buffer.data(), len);
+            ++callbacks;
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const double us = std::chrono::duration<double, std::micro>(end - start).count() / callbacks;
+        std::cout << stems << ';' << us << ';' << us / budget << '\n';
+    }
+    return EXIT_SUCCESS;
+}
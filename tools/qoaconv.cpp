@@ -0,0 +1,99 @@
+#include <qoafile.h>
+#include <qoasource.h>
+#include <wave.h>
+
+#include <SDL.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string get_output_filename(const std::string &input) {
+    const std::string::size_type dot = input.find_last_of('.');
+    const std::string::size_type slash = input.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return input + ".qoa";
+    }
+    return input.substr(0, dot) + ".qoa";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <song.wav> [output.qoa]\n";
+        return EXIT_FAILURE;
+    }
+    if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+        std::cerr << SDL_GetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string output = argc > 2 ? argv[2] : get_output_filename(argv[1]);
+    try {
+        const Wave wav(argv[1]);
+        SDL_AudioSpec spec = wav.get_spec();
+        spec.format = AUDIO_S16SYS;
+        const std::vector<Uint8> converted = wav.convert_to_spec(spec);
+        std::vector<Sint16> pcm(converted.size() / sizeof(Sint16));
+        memcpy(pcm.data(), converted.data(), pcm.size() * sizeof(Sint16));
+        const size_t frames = pcm.size() / spec.channels;
+        const double seconds = static_cast<double>(frames) / spec.freq;
+
+        const auto encode_start = std::chrono::steady_clock::now();
+        QOAFile::write(output, pcm.data(), spec.channels, spec.freq, frames);
+        const auto encode_end = std::chrono::steady_clock::now();
+
+        auto file = std::make_shared<const QOAFile>(output);
+        std::vector<Sint16> decoded(file->get_length() * spec.channels);
+        const auto decode_start = std::chrono::steady_clock::now();
+        for (size_t block = 0; block < file->get_num_blocks(); ++block) {
+            file->decode_block(block, decoded.data() + block * QOAFile::BLOCK_FRAMES * spec.channels);
+        }
+        const auto decode_end = std::chrono::steady_clock::now();
+
+        double signal = 0.0;
+        double noise = 0.0;
+        for (size_t i = 0; i < pcm.size(); ++i) {
+            const double difference = static_cast<double>(pcm[i]) - decoded[i];
+            signal += static_cast<double>(pcm[i]) * pcm[i];
+            noise += difference * difference;
+        }
+
+        SDL_AudioSpec device = spec;
+        device.format = AUDIO_F32SYS;
+        QOASource source(file, device);
+        const size_t callback_frames = 1024;
+        std::vector<float> buffer(callback_frames * spec.channels);
+        const auto stream_start = std::chrono::steady_clock::now();
+        for (size_t position = 0; position < frames; position += callback_frames) {
+            source.read(position, buffer.data(), callback_frames);
+        }
+        const auto stream_end = std::chrono::steady_clock::now();
+
+        const double pcm_size = static_cast<double>(frames * spec.channels * sizeof(float));
+        const double qoa_size = static_cast<double>(file->get_size() + source.get_resident_size());
+        std::cout << "Wrote " << seconds << " s of audio to " << output << '\n'
+                  << "Encoding took " << std::chrono::duration<double, std::milli>(encode_end - encode_start).count() << " ms\n"
+                  << "Decoding takes " << std::chrono::duration<double, std::micro>(decode_end - decode_start).count() / seconds
+                  << " us per second of audio, streaming in callbacks of " << callback_frames << " frames "
+                  << std::chrono::duration<double, std::micro>(stream_end - stream_start).count() / seconds
+                  << " us (" << source.get_misses() << " blocks decoded in the callback)\n"
+                  << "Signal to noise ratio: " << 10.0 * std::log10(signal / std::max(noise, 1.0)) << " dB\n"
+                  << "Memory: " << pcm_size / (1 << 20) << " MiB as float PCM, "
+                  << qoa_size / (1 << 20) << " MiB as QOA with decode buffers\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
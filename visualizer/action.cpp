@@ -1,6 +1,7 @@
 #include "action.h"
 
 #include <SDL_stdinc.h>
+#include <featurecache.h>
 
 #include <cmath>
 #include <stdexcept>
@@ -224,9 +225,50 @@ public:
     }
 };
 
+class Feature : public Action {
+public:
+    Feature(float start, const ActionContext &context, FeatureExtractor::Feature feature,
+            float look_behind, float look_ahead, float scale)
+      : Action(start),
+        context(context),
+        feature(feature),
+        look_behind(look_behind),
+        look_ahead(look_ahead),
+        scale(scale)
+    { }
+
+    float get_value(float measure) const override {
+        if (context.features == nullptr) {
+            return 0.0f;
+        }
+        const float seconds_per_measure = context.ms_per_measure / 1000.0f;
+        const float offset = context.offset / 1000.0f;
+        const float begin = offset + (measure - look_behind) * seconds_per_measure;
+        const float end = offset + (measure + look_ahead) * seconds_per_measure;
+        return scale * context.features->get_mean(feature, begin, end);
+    }
+
+private:
+    const ActionContext &context;
+    FeatureExtractor::Feature feature;
+    float look_behind;
+    float look_ahead;
+    float scale;
+};
+
+FeatureExtractor::Feature parse_feature(const std::string &name) {
+    for (int i = 0; i < FeatureExtractor::NUM_FEATURES; ++i) {
+        const auto feature = static_cast<FeatureExtractor::Feature>(i);
+        if (name == FeatureExtractor::get_name(feature)) {
+            return feature;
+        }
+    }
+    throw std::runtime_error("Unknown audio feature " + name);
+}
+
 }
 
-std::unique_ptr<Action> create_action(float start, const nlohmann::json &action) {
+std::unique_ptr<Action> create_action(float start, const nlohmann::json &action, const ActionContext &context) {
     const std::string &name = action.at("action").get<std::string>();
     const auto &parameters = action.at("parameters");
     if (name == "step") {
@@ -240,6 +282,12 @@ std::unique_ptr<Action> create_action(float start, const nlohmann::json &action)
     } else if (name == "spline") {
         const auto &control_points = parameters["control-points"];
         return std::make_unique<Spline>(start, control_points);
+    } else if (name == "feature") {
+        const FeatureExtractor::Feature feature = parse_feature(parameters["feature"].get<std::string>());
+        const float look_behind = parameters.value("look-behind", 0.0f);
+        const float look_ahead = parameters.value("look-ahead", 0.0f);
+        const float scale = parameters.value("scale", 1.0f);
+        return std::make_unique<Feature>(start, context, feature, look_behind, look_ahead, scale);
     } else {
         throw std::runtime_error("Unknown action " + name);
     }
@@ -6,8 +6,16 @@
 #include <memory>
 #include <vector>
 
+class FeatureCache;
+
 namespace visualizer {
 
+struct ActionContext {
+    float ms_per_measure;
+    float offset;
+    const FeatureCache *features;
+};
+
 class Action {
 public:
     explicit Action(float start);
@@ -46,6 +54,6 @@ inline bool operator < (const std::unique_ptr<Action> &pa, const std::unique_ptr
     return pa->get_start() < pb->get_start();
 }
 
-std::unique_ptr<Action> create_action(float start, const nlohmann::json &action);
+std::unique_ptr<Action> create_action(float start, const nlohmann::json &action, const ActionContext &context);
 
 }
@@ -1,14 +1,97 @@
 #include "batch.h"
 
-#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <stdexcept>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BATCH_SSE
+#include <xmmintrin.h>
+#endif
+#ifdef __AVX__
+#define BATCH_AVX
+#include <immintrin.h>
+#endif
+
 namespace visualizer {
 
 namespace {
 
-const std::vector<GLfloat>::size_type CAPACITY = 10000 * 7;
+Batch::Vertex pack_attributes(const glm::vec3 &color, float glow) {
+    Batch::Vertex vertex{};
+    for (int i = 0; i < 3; ++i) {
+        vertex.color[i] = static_cast<GLubyte>(std::lround(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f));
+    }
+    vertex.color[3] = 255;
+    vertex.glow = glm::packHalf1x16(glow);
+    return vertex;
+}
+
+void set_attributes(Batch::Vertex &out, const Batch::Vertex &attributes) {
+    memcpy(out.color, attributes.color, sizeof(out.color));
+    out.glow = attributes.glow;
+    out.padding = 0;
+}
+
+// All kernels compute model * v as ((m0 * x + m1 * y) + m2 * z) + m3 * w,
+// in the order glm uses for the columns of a matrix product, so that they
+// give the same result as add_triangle(model * triangle). The vector
+// kernels store four floats for the position and overwrite the fourth with
+// the attributes.
+
+void transform_scalar(const glm::mat4 &m, const glm::vec4 *in, size_t count, const Batch::Vertex &attributes, Batch::Vertex *out) {
+    for (size_t i = 0; i < count; ++i) {
+        const glm::vec4 v = m[0] * in[i].x + m[1] * in[i].y + m[2] * in[i].z + m[3] * in[i].w;
+        out[i].position[0] = v.x;
+        out[i].position[1] = v.y;
+        out[i].position[2] = v.z;
+        set_attributes(out[i], attributes);
+    }
+}
+
+#ifdef BATCH_SSE
+void transform_sse(const glm::mat4 &m, const glm::vec4 *in, size_t count, const Batch::Vertex &attributes, Batch::Vertex *out) {
+    const __m128 m0 = _mm_loadu_ps(&m[0].x);
+    const __m128 m1 = _mm_loadu_ps(&m[1].x);
+    const __m128 m2 = _mm_loadu_ps(&m[2].x);
+    const __m128 m3 = _mm_loadu_ps(&m[3].x);
+    for (size_t i = 0; i < count; ++i) {
+        const __m128 v = _mm_loadu_ps(&in[i].x);
+        __m128 r = _mm_mul_ps(m0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(m3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_storeu_ps(out[i].position, r);
+        set_attributes(out[i], attributes);
+    }
+}
+#endif
+
+#ifdef BATCH_AVX
+void transform_avx(const glm::mat4 &m, const glm::vec4 *in, size_t count, const Batch::Vertex &attributes, Batch::Vertex *out) {
+    const __m256 m0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&m[0].x));
+    const __m256 m1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&m[1].x));
+    const __m256 m2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&m[2].x));
+    const __m256 m3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&m[3].x));
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256 v = _mm256_loadu_ps(&in[i].x);
+        __m256 r = _mm256_mul_ps(m0, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(m1, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm256_add_ps(r, _mm256_mul_ps(m2, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm256_add_ps(r, _mm256_mul_ps(m3, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_storeu_ps(out[i].position, _mm256_castps256_ps128(r));
+        set_attributes(out[i], attributes);
+        _mm_storeu_ps(out[i + 1].position, _mm256_extractf128_ps(r, 1));
+        set_attributes(out[i + 1], attributes);
+    }
+    transform_sse(m, in + i, count - i, attributes, out + i);
+}
+#endif
 
 }
 
@@ -16,52 +99,225 @@ const int Batch::ATTRIBUTE_POSITION = 0;
 const int Batch::ATTRIBUTE_COLOR = 1;
 const int Batch::ATTRIBUTE_GLOW = 2;
 
-Batch::Batch() {
+const size_t Batch::CHUNK_VERTICES = 65536;
+const size_t Batch::CHUNK_INDICES = 3 * CHUNK_VERTICES;
+
+bool Batch::is_supported(Kernel kernel) {
+    switch (kernel) {
+    case Kernel::SCALAR:
+        return true;
+    case Kernel::SSE:
+#ifdef BATCH_SSE
+        return true;
+#else
+        return false;
+#endif
+    case Kernel::AVX:
+#ifdef BATCH_AVX
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+Batch::Chunk::Chunk(StreamBuffer::Mode mode)
+  : vertex_buffer(CHUNK_VERTICES * sizeof(Vertex), mode),
+    index_buffer(CHUNK_INDICES * sizeof(Index), mode),
+    vertices(nullptr),
+    indices(nullptr),
+    num_vertices(0),
+    num_indices(0)
+{
     auto binding = vao.bind();
     binding.enable_attribute(ATTRIBUTE_POSITION);
     binding.enable_attribute(ATTRIBUTE_COLOR);
     binding.enable_attribute(ATTRIBUTE_GLOW);
+    binding.element_buffer(index_buffer.get_buffer());
+
+    auto buffer_binding = vertex_buffer.get_buffer().bind(GL_ARRAY_BUFFER);
+    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
+    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void *)offsetof(Vertex, color));
+    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_GLOW, 1, GL_HALF_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, glow));
+}
+
+Batch::Batch()
+  : kernel(Kernel::SCALAR),
+    streaming(StreamBuffer::get_default_mode()),
+    num_chunks(0),
+    mapped(false),
+    num_vertices(0),
+    num_indices(0),
+    map_time(0)
+{
+    clear();
+
+    for (Kernel best : { Kernel::AVX, Kernel::SSE }) {
+        if (is_supported(best)) {
+            kernel = best;
+            break;
+        }
+    }
+}
 
-    auto buffer_binding = vertex_buffer.bind(GL_ARRAY_BUFFER);
-    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 7, (void *)(0 * sizeof(GLfloat)));
-    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 7, (void *)(3 * sizeof(GLfloat)));
-    buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_GLOW, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 7, (void *)(6 * sizeof(GLfloat)));
-    buffer_binding.data(CAPACITY * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+void Batch::set_kernel(Kernel kernel) {
+    if (!is_supported(kernel)) {
+        throw std::runtime_error("Vertex kernel isn't supported by this build");
+    }
+    this->kernel = kernel;
+}
 
-    batch.reserve(CAPACITY);
+void Batch::set_streaming(StreamBuffer::Mode mode) {
+    if (!StreamBuffer::is_supported(mode)) {
+        throw std::runtime_error("Persistently mapped buffers aren't supported");
+    }
+    chunks.clear();
+    streaming = mode;
+    mapped = false;
+    clear();
 }
 
-void Batch::add_vertex(const glm::vec3 &vertex, const glm::vec3 &color, float glow) {
-    if (batch.size() == CAPACITY) {
-        throw std::runtime_error("Maximal number of batched vertices already reached");
+void Batch::add_triangle(const glm::mat3 &triangle, const glm::vec3 &color, float glow) {
+    const Range range = allocate(3, 3);
+    const Vertex attributes = pack_attributes(color, glow);
+    for (int i = 0; i < 3; ++i) {
+        range.vertices[i].position[0] = triangle[i].x;
+        range.vertices[i].position[1] = triangle[i].y;
+        range.vertices[i].position[2] = triangle[i].z;
+        set_attributes(range.vertices[i], attributes);
+        range.indices[i] = static_cast<Index>(range.first + i);
     }
-    batch.push_back(vertex.x);
-    batch.push_back(vertex.y);
-    batch.push_back(vertex.z);
-    batch.push_back(color.r);
-    batch.push_back(color.g);
-    batch.push_back(color.b);
-    batch.push_back(glow);
 }
 
+void Batch::add_vertices(const glm::mat4 &model, const std::vector<glm::vec4> &vertices, const std::vector<Index> &indices, const glm::vec3 &color, float glow) {
+    const Range range = allocate(vertices.size(), indices.size());
+    transform(model, vertices, color, glow, range.vertices);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        range.indices[i] = static_cast<Index>(range.first + indices[i]);
+    }
+}
 
-void Batch::add_triangle(const glm::mat3 &vertices, const glm::vec3 &color, float glow) {
-    add_vertex(vertices[0], color, glow);
-    add_vertex(vertices[1], color, glow);
-    add_vertex(vertices[2], color, glow);
+// Chunks are kept when the batch is cleared, and only mapped once they are
+// needed again.
+void Batch::next_chunk() {
+    if (num_chunks == chunks.size()) {
+        chunks.push_back(std::make_unique<Chunk>(streaming));
+    }
+    Chunk &chunk = *chunks[num_chunks++];
+    chunk.vertices = static_cast<Vertex *>(chunk.vertex_buffer.map());
+    chunk.indices = static_cast<Index *>(chunk.index_buffer.map());
+    chunk.num_vertices = 0;
+    chunk.num_indices = 0;
+    map_time += chunk.vertex_buffer.get_map_time() + chunk.index_buffer.get_map_time();
+}
+
+Batch::Range Batch::allocate(size_t num_vertices, size_t num_indices) {
+    if (!mapped) {
+        throw std::runtime_error("Batch has to be cleared after drawing");
+    }
+    if (num_vertices > CHUNK_VERTICES || num_indices > CHUNK_INDICES) {
+        throw std::runtime_error("Too many vertices for a chunk of the batch");
+    }
+    if (chunks[num_chunks - 1]->num_vertices + num_vertices > CHUNK_VERTICES
+            || chunks[num_chunks - 1]->num_indices + num_indices > CHUNK_INDICES) {
+        next_chunk();
+    }
+    Chunk &chunk = *chunks[num_chunks - 1];
+    const Range range{ chunk.vertices + chunk.num_vertices, chunk.indices + chunk.num_indices, static_cast<Index>(chunk.num_vertices) };
+    chunk.num_vertices += num_vertices;
+    chunk.num_indices += num_indices;
+    this->num_vertices += num_vertices;
+    this->num_indices += num_indices;
+    return range;
+}
+
+void Batch::transform(const glm::mat4 &model, const std::vector<glm::vec4> &vertices, const glm::vec3 &color, float glow, Vertex *out) const {
+    const Vertex attributes = pack_attributes(color, glow);
+    switch (kernel) {
+#ifdef BATCH_AVX
+    case Kernel::AVX:
+        transform_avx(model, vertices.data(), vertices.size(), attributes, out);
+        break;
+#endif
+#ifdef BATCH_SSE
+    case Kernel::SSE:
+        transform_sse(model, vertices.data(), vertices.size(), attributes, out);
+        break;
+#endif
+    default:
+        transform_scalar(model, vertices.data(), vertices.size(), attributes, out);
+        break;
+    }
 }
 
 void Batch::clear() {
-    batch.clear();
+    num_chunks = 0;
+    num_vertices = 0;
+    num_indices = 0;
+    map_time = 0;
+    if (!mapped) {
+        mapped = true;
+        next_chunk();
+    } else {
+        num_chunks = 1;
+        chunks[0]->num_vertices = 0;
+        chunks[0]->num_indices = 0;
+    }
 }
 
-void Batch::draw() const {
-    auto binding = vao.bind();
-    auto buffer_binding = vertex_buffer.bind(GL_ARRAY_BUFFER);
-    buffer_binding.subdata(0, batch.size() * sizeof(GLfloat), batch.data());
-    //void *data = glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-    //glUnmapBuffer(GL_ARRAY_BUFFER);
-    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.size()));
+// Each chunk is drawn on its own, as a multi-draw can't span buffers.
+void Batch::draw() {
+    for (size_t i = 0; i < num_chunks; ++i) {
+        Chunk &chunk = *chunks[i];
+        const GLintptr vertex_offset = chunk.vertex_buffer.unmap(chunk.num_vertices * sizeof(Vertex));
+        const GLintptr index_offset = chunk.index_buffer.unmap(chunk.num_indices * sizeof(Index));
+        chunk.vertices = nullptr;
+        chunk.indices = nullptr;
+        {
+            auto binding = chunk.vao.bind();
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(chunk.num_indices), GL_UNSIGNED_SHORT,
+                reinterpret_cast<const void *>(index_offset), static_cast<GLint>(vertex_offset / sizeof(Vertex)));
+        }
+        chunk.vertex_buffer.fence();
+        chunk.index_buffer.fence();
+    }
+    mapped = false;
+}
+
+std::vector<Batch::Vertex> Batch::read_back() {
+    std::vector<Vertex> contents;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        Chunk &chunk = *chunks[i];
+        const GLsizeiptr vertex_size = chunk.num_vertices * sizeof(Vertex);
+        const GLsizeiptr index_size = chunk.num_indices * sizeof(Index);
+        const GLintptr vertex_offset = chunk.vertex_buffer.unmap(vertex_size);
+        const GLintptr index_offset = chunk.index_buffer.unmap(index_size);
+        chunk.vertices = nullptr;
+        chunk.indices = nullptr;
+        if (chunk.num_indices == 0) {
+            continue;
+        }
+
+        Buffer vertex_copy;
+        Buffer index_copy;
+        vertex_copy.data(vertex_size, nullptr, GL_STREAM_READ);
+        index_copy.data(index_size, nullptr, GL_STREAM_READ);
+        vertex_copy.copy_subdata(chunk.vertex_buffer.get_buffer(), vertex_offset, 0, vertex_size);
+        index_copy.copy_subdata(chunk.index_buffer.get_buffer(), index_offset, 0, index_size);
+        const Vertex *vertices = static_cast<const Vertex *>(vertex_copy.map_range(0, vertex_size, GL_MAP_READ_BIT));
+        const Index *indices = static_cast<const Index *>(index_copy.map_range(0, index_size, GL_MAP_READ_BIT));
+        if (vertices == nullptr || indices == nullptr) {
+            throw std::runtime_error("Can't map batch for reading");
+        }
+        for (size_t j = 0; j < chunk.num_indices; ++j) {
+            contents.push_back(vertices[indices[j]]);
+        }
+        vertex_copy.unmap();
+        index_copy.unmap();
+    }
+    mapped = false;
+    return contents;
 }
 
 }
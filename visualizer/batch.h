@@ -2,33 +2,115 @@
 
 #include <GL/glew.h>
 #include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 
-#include <buffer.h>
+#include <streambuffer.h>
 #include <vertexarray.h>
 
+#include <memory>
 #include <vector>
 
 namespace visualizer {
 
 class Batch {
 public:
+    enum class Kernel {
+        SCALAR,
+        SSE,
+        AVX
+    };
+
+    // Color and glow are the same for all vertices of a shape and don't need
+    // the precision of the position, so a vertex takes 20 bytes instead of
+    // the 28 of seven floats. The glow is a half float.
+    struct Vertex {
+        GLfloat position[3];
+        GLubyte color[4];
+        GLushort glow;
+        GLushort padding;
+    };
+
+    typedef GLushort Index;
+
+    // Room reserved at the end of the batch. The vertices are numbered from
+    // first on.
+    struct Range {
+        Vertex *vertices;
+        Index *indices;
+        Index first;
+    };
+
     static const int ATTRIBUTE_POSITION;
     static const int ATTRIBUTE_COLOR;
     static const int ATTRIBUTE_GLOW;
 
+    // The batch grows in chunks with buffers of their own, so nothing needs
+    // to be copied when it does. Indices count from the start of their
+    // chunk, which limits its size, and a single allocation has to fit into
+    // one chunk.
+    static const size_t CHUNK_VERTICES;
+    static const size_t CHUNK_INDICES;
+
+    static bool is_supported(Kernel kernel);
+
     Batch();
 
     void add_triangle(const glm::mat3 &vertices, const glm::vec3 &color, float glow);
+    void add_vertices(const glm::mat4 &model, const std::vector<glm::vec4> &vertices, const std::vector<Index> &indices, const glm::vec3 &color, float glow);
+
+    // Reserves room for vertices and indices at the end of the batch, to be
+    // filled by transform() and with indices counted from range.first,
+    // possibly from several threads at once.
+    Range allocate(size_t num_vertices, size_t num_indices);
+    void transform(const glm::mat4 &model, const std::vector<glm::vec4> &vertices, const glm::vec3 &color, float glow, Vertex *out) const;
+
+    void set_kernel(Kernel kernel);
+    // Drops the vertices added since clear().
+    void set_streaming(StreamBuffer::Mode mode);
+
+    size_t get_num_chunks() const { return num_chunks; }
+    size_t get_num_vertices(size_t chunk) const { return chunks[chunk]->num_vertices; }
+    size_t get_num_indices(size_t chunk) const { return chunks[chunk]->num_indices; }
+    size_t get_num_vertices() const { return num_vertices; }
+    size_t get_num_indices() const { return num_indices; }
+    // The bytes of vertices and indices added since clear().
+    size_t get_size() const { return num_vertices * sizeof(Vertex) + num_indices * sizeof(Index); }
+    StreamBuffer::Mode get_streaming() const { return streaming; }
+    // The nanoseconds it took to get regions to write to since clear().
+    GLuint64 get_map_time() const { return map_time; }
 
     void clear();
-    void draw() const;
+    void draw();
+    // Ends the batch like draw() without drawing it, and returns the vertices
+    // of the triangles in the order they would be drawn. The vertices and
+    // indices are written straight into regions of the buffers of the chunks
+    // that are mapped for writing only, so they're copied into buffers mapped
+    // for reading first, which is slow.
+    std::vector<Vertex> read_back();
 private:
-    VertexArray vao;
-    Buffer vertex_buffer;
+    struct Chunk {
+        VertexArray vao;
+        StreamBuffer vertex_buffer;
+        StreamBuffer index_buffer;
+        Vertex *vertices;
+        Index *indices;
+        size_t num_vertices;
+        size_t num_indices;
+
+        explicit Chunk(StreamBuffer::Mode mode);
+    };
 
-    void add_vertex(const glm::vec3 &vertex, const glm::vec3 &color, float glow);
+    Kernel kernel;
+    StreamBuffer::Mode streaming;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    size_t num_chunks;
+    bool mapped;
+    size_t num_vertices;
+    size_t num_indices;
+    GLuint64 map_time;
 
-    std::vector<GLfloat> batch;
+    void next_chunk();
 };
 
 }
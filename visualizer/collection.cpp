@@ -1,14 +1,25 @@
 #include "collection.h"
 
+#include "drawlist.h"
+
 namespace visualizer {
 
 Collection::Collection(std::initializer_list<std::shared_ptr<Object>> objects)
     : objects(objects) { }
 
+Collection::Collection(std::vector<std::shared_ptr<Object>> objects)
+    : objects(std::move(objects)) { }
+
 void Collection::draw(Batch &batch, const glm::mat4 &model) const {
     for (const auto &item : objects) {
         item->draw(batch, model);
     }
 }
 
+void Collection::compile(DrawList &list, size_t parent) const {
+    for (const auto &item : objects) {
+        item->compile(list, parent);
+    }
+}
+
 }
@@ -10,8 +10,10 @@ namespace visualizer {
 class Collection : public Object {
 public:
     explicit Collection(std::initializer_list<std::shared_ptr<Object>> objects);
+    explicit Collection(std::vector<std::shared_ptr<Object>> objects);
 
     void draw(Batch &batch, const glm::mat4 &model) const override;
+    void compile(DrawList &list, size_t parent) const override;
 
 private:
     std::vector<std::shared_ptr<Object>> objects;
@@ -0,0 +1,379 @@
+#include "drawlist.h"
+
+#include "batch.h"
+#include "instancedbatch.h"
+#include "object.h"
+#include "shape.h"
+
+#include <threadpool.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace visualizer {
+
+namespace {
+
+// glm::rotate() around the z axis, written out so that the sine and cosine
+// can be computed once for all rotations by the same angle. The result is
+// the same as the one of glm::rotate().
+glm::mat4 rotate_z(const glm::mat4 &m, float c, float s) {
+    glm::mat4 result;
+    result[0] = m[0] * c + m[1] * s;
+    result[1] = m[0] * -s + m[1] * c;
+    result[2] = m[2] * (c + (1.0f - c));
+    result[3] = m[3];
+    return result;
+}
+
+}
+
+const size_t DrawList::NONE = std::numeric_limits<size_t>::max();
+
+DrawList::DrawList(const Object &root)
+  : segments{{ 0, 0, 0, true, 0, 0, 0.0f, 0, 0 }},
+    chunks_threads(0),
+    num_vertices(0),
+    meshes_batch(nullptr),
+    has_view(false),
+    view_projection(1.0f),
+    pixels_per_unit(0.0f)
+{
+    root.compile(*this, ROOT);
+    models.resize(transforms.size() + 1, glm::mat4(1.0f));
+    versions.assign(transforms.size() + 1, 1);
+    segments.push_back({ transforms.size(), shapes.size(), 0, true, 0, 0, 0.0f, 0, 0 });
+    for (ShapeInstance &shape : shapes) {
+        shape.offset = num_vertices;
+        num_vertices += shape.shape->get_levels().back().vertices.size();
+    }
+    for (size_t i = 0; i < segments.size(); ++i) {
+        Segment &segment = segments[i];
+        segment.vertex = segment.shape < shapes.size() ? shapes[segment.shape].offset : num_vertices;
+        for (size_t j = segment.shape; i + 1 < segments.size() && j < segments[i + 1].shape; ++j) {
+            segment.fixed = segment.fixed && shapes[j].shape->get_levels().size() == 1;
+        }
+    }
+    vertices.resize(num_vertices);
+    ranges.resize(segments.size() - 1);
+    shape_ranges.resize(shapes.size());
+}
+
+// The last value starts out as NaN, so that the first draw takes it over.
+size_t DrawList::add_input(const float &value, bool angle) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].value == &value) {
+            inputs[i].angle = inputs[i].angle || angle;
+            return i;
+        }
+    }
+    inputs.push_back({ &value, std::numeric_limits<float>::quiet_NaN(), 0, angle, 1.0f, 0.0f });
+    return inputs.size() - 1;
+}
+
+size_t DrawList::add_transform(Op op, size_t parent, size_t a, size_t b, const glm::vec3 &constant) {
+    if (parent == ROOT && (segments.back().transform != transforms.size() || segments.back().shape != shapes.size())) {
+        segments.push_back({ transforms.size(), shapes.size(), 0, true, 0, 0, 0.0f, 0, 0 });
+    }
+    transforms.push_back({ op, parent, a, b, constant, 0, 0, 0 });
+    return transforms.size();
+}
+
+size_t DrawList::add_scale(size_t parent, const float &x, const float &y) {
+    return add_transform(Op::SCALE, parent, add_input(x), add_input(y), glm::vec3(0.0f));
+}
+
+size_t DrawList::add_rotate(size_t parent, const float &degree) {
+    return add_transform(Op::ROTATE, parent, add_input(degree, true), NONE, glm::vec3(0.0f));
+}
+
+size_t DrawList::add_translate(size_t parent, const glm::vec3 &direction, const float *z) {
+    return add_transform(Op::TRANSLATE, parent, z != nullptr ? add_input(*z) : NONE, NONE, direction);
+}
+
+size_t DrawList::add_ring_slot(size_t parent, float degree, float radius) {
+    const float radians = glm::radians(degree);
+    return add_transform(Op::RING_SLOT, parent, NONE, NONE, glm::vec3(std::cos(radians), std::sin(radians), radius));
+}
+
+void DrawList::add_shape(size_t parent, const Shape &shape, const float &glow) {
+    shapes.push_back({ parent, shape.get_color(), add_input(glow), &shape, shape.get_default_level(), 0.0f, 0, 0, 0, 0 });
+}
+
+// The levels of the shapes are chosen again the next time they are drawn,
+// as the transformed vertices are dropped with the versions of the matrices.
+void DrawList::set_view(const glm::mat4 &projection, const glm::mat4 &view, int viewport_size) {
+    has_view = true;
+    view_projection = projection * view;
+    pixels_per_unit = projection[1][1] * static_cast<float>(viewport_size) / 2.0f;
+    for (unsigned int &version : versions) {
+        ++version;
+    }
+}
+
+float DrawList::get_transform_hit_rate() const {
+    size_t computed = 0;
+    for (const Segment &segment : segments) {
+        computed += segment.computed_transforms;
+    }
+    return transforms.empty() ? 1.0f : 1.0f - static_cast<float>(computed) / transforms.size();
+}
+
+float DrawList::get_shape_hit_rate() const {
+    size_t computed = 0;
+    for (const Segment &segment : segments) {
+        computed += segment.computed_shapes;
+    }
+    return shapes.empty() ? 1.0f : 1.0f - static_cast<float>(computed) / shapes.size();
+}
+
+size_t DrawList::get_num_vertices() const {
+    size_t count = 0;
+    for (const Segment &segment : segments) {
+        count += segment.count;
+    }
+    return count;
+}
+
+float DrawList::get_max_error() const {
+    float error = 0.0f;
+    for (const Segment &segment : segments) {
+        error = std::max(error, segment.error);
+    }
+    return error;
+}
+
+void DrawList::update_inputs(const glm::mat4 &model) {
+    for (Input &input : inputs) {
+        if (*input.value != input.last) {
+            input.last = *input.value;
+            ++input.version;
+            if (input.angle) {
+                const float radians = glm::radians(input.last);
+                input.cos = std::cos(radians);
+                input.sin = std::sin(radians);
+            }
+        }
+    }
+    if (models[ROOT] != model) {
+        models[ROOT] = model;
+        ++versions[ROOT];
+    }
+}
+
+// Slot 0 holds the model matrix, slot i + 1 the result of transform i.
+void DrawList::update(size_t segment) {
+    Segment &range = segments[segment];
+    range.computed_transforms = 0;
+    for (size_t i = range.transform; i < segments[segment + 1].transform; ++i) {
+        Transform &t = transforms[i];
+        const unsigned int a_version = t.a != NONE ? inputs[t.a].version : 0;
+        const unsigned int b_version = t.b != NONE ? inputs[t.b].version : 0;
+        if (t.parent_version == versions[t.parent] && t.a_version == a_version && t.b_version == b_version) {
+            continue;
+        }
+        t.parent_version = versions[t.parent];
+        t.a_version = a_version;
+        t.b_version = b_version;
+        ++versions[i + 1];
+        ++range.computed_transforms;
+
+        const glm::mat4 &parent = models[t.parent];
+        switch (t.op) {
+        case Op::SCALE:
+            models[i + 1] = glm::scale(parent, glm::vec3(inputs[t.a].last, inputs[t.b].last, 1.0f));
+            break;
+        case Op::ROTATE:
+            models[i + 1] = rotate_z(parent, inputs[t.a].cos, inputs[t.a].sin);
+            break;
+        case Op::TRANSLATE:
+            models[i + 1] = glm::translate(parent, glm::vec3(t.constant.x, t.constant.y, t.a != NONE ? inputs[t.a].last : t.constant.z));
+            break;
+        case Op::RING_SLOT:
+            models[i + 1] = glm::translate(rotate_z(parent, t.constant.x, t.constant.y), glm::vec3(0.0f, t.constant.z, 0.0f));
+            break;
+        }
+    }
+}
+
+// Shapes are unit sized, so their projected size is half the length of the
+// longer axis of their matrix, divided by the depth of their center. Shapes
+// behind the camera get the coarsest level.
+size_t DrawList::select_level(const ShapeInstance &shape, float &size) const {
+    size = 0.0f;
+    if (!has_view) {
+        return shape.shape->get_default_level();
+    }
+    const glm::mat4 &m = models[shape.transform];
+    const float w = (view_projection * m[3]).w;
+    if (w <= 0.0f) {
+        return 0;
+    }
+    const float radius = 0.5f * std::max(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])));
+    size = radius * pixels_per_unit / w;
+    return shape.shape->select_level(size);
+}
+
+// Shapes whose matrix and glow didn't change since they were last
+// transformed are left in the cache.
+void DrawList::transform(const Batch &batch, size_t segment) {
+    update(segment);
+    Segment &begin = segments[segment];
+    const Segment &end = segments[segment + 1];
+    begin.count = 0;
+    begin.index_count = 0;
+    begin.error = 0.0f;
+    begin.computed_shapes = 0;
+    for (size_t i = begin.shape; i < end.shape; ++i) {
+        ShapeInstance &shape = shapes[i];
+        const Input &glow = inputs[shape.glow];
+        if (shape.transform_version != versions[shape.transform] || shape.glow_version != glow.version) {
+            shape.transform_version = versions[shape.transform];
+            shape.glow_version = glow.version;
+            float size;
+            shape.level = select_level(shape, size);
+            const Shape::Level &level = shape.shape->get_levels()[shape.level];
+            shape.error = size * level.error;
+            batch.transform(models[shape.transform], level.vertices, shape.color, glow.last, vertices.data() + shape.offset);
+            ++begin.computed_shapes;
+        }
+        const Shape::Level &level = shape.shape->get_levels()[shape.level];
+        begin.count += level.vertices.size();
+        begin.index_count += level.indices.size();
+        begin.error = std::max(begin.error, shape.error);
+    }
+}
+
+// Reserves the room of the segments in the batch.
+void DrawList::place(Batch &batch) {
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        const Segment &segment = segments[i];
+        if (segment.count <= Batch::CHUNK_VERTICES && segment.index_count <= Batch::CHUNK_INDICES) {
+            ranges[i] = batch.allocate(segment.count, segment.index_count);
+            continue;
+        }
+        ranges[i] = { nullptr, nullptr, 0 };
+        for (size_t j = segment.shape; j < segments[i + 1].shape; ++j) {
+            const Shape::Level &level = shapes[j].shape->get_levels()[shapes[j].level];
+            shape_ranges[j] = batch.allocate(level.vertices.size(), level.indices.size());
+        }
+    }
+}
+
+void DrawList::copy(size_t segment) const {
+    const Segment &begin = segments[segment];
+    const Segment &end = segments[segment + 1];
+    const Batch::Range &range = ranges[segment];
+    if (range.vertices == nullptr) {
+        for (size_t i = begin.shape; i < end.shape; ++i) {
+            const ShapeInstance &shape = shapes[i];
+            const Shape::Level &level = shape.shape->get_levels()[shape.level];
+            const Batch::Range &shape_range = shape_ranges[i];
+            memcpy(shape_range.vertices, vertices.data() + shape.offset, level.vertices.size() * sizeof(Batch::Vertex));
+            for (size_t j = 0; j < level.indices.size(); ++j) {
+                shape_range.indices[j] = static_cast<Batch::Index>(shape_range.first + level.indices[j]);
+            }
+        }
+        return;
+    }
+    Batch::Vertex *out = range.vertices;
+    Batch::Index *indices = range.indices;
+    size_t first = range.first;
+    if (begin.fixed) {
+        memcpy(out, vertices.data() + begin.vertex, begin.count * sizeof(Batch::Vertex));
+    }
+    for (size_t i = begin.shape; i < end.shape; ++i) {
+        const ShapeInstance &shape = shapes[i];
+        const Shape::Level &level = shape.shape->get_levels()[shape.level];
+        if (!begin.fixed) {
+            memcpy(out, vertices.data() + shape.offset, level.vertices.size() * sizeof(Batch::Vertex));
+            out += level.vertices.size();
+        }
+        for (GLushort index : level.indices) {
+            *indices++ = static_cast<Batch::Index>(first + index);
+        }
+        first += level.vertices.size();
+    }
+}
+
+void DrawList::draw(Batch &batch, const glm::mat4 &model) {
+    update_inputs(model);
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        transform(batch, i);
+    }
+    place(batch);
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        copy(i);
+    }
+}
+
+// Cuts the segments into a few chunks per thread, so that a thread that
+// finishes early can take over work from a slow one.
+void DrawList::split(size_t num_threads) {
+    const size_t num_chunks = num_threads * 4;
+    const size_t work = transforms.size() + num_vertices;
+    chunks.assign(1, 0);
+    size_t done = 0;
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        done += segments[i + 1].transform - segments[i].transform + segments[i + 1].vertex - segments[i].vertex;
+        if (done * num_chunks >= work * chunks.size() || i + 2 == segments.size()) {
+            chunks.push_back(i + 1);
+        }
+    }
+    chunks_threads = num_threads;
+}
+
+void DrawList::draw(Batch &batch, const glm::mat4 &model, ThreadPool &pool) {
+    if (chunks_threads != pool.get_num_threads()) {
+        split(pool.get_num_threads());
+    }
+    update_inputs(model);
+    pool.run(chunks.size() - 1, [&](size_t chunk) {
+        for (size_t i = chunks[chunk]; i < chunks[chunk + 1]; ++i) {
+            transform(batch, i);
+        }
+    });
+    place(batch);
+    pool.run(chunks.size() - 1, [&](size_t chunk) {
+        for (size_t i = chunks[chunk]; i < chunks[chunk + 1]; ++i) {
+            copy(i);
+        }
+    });
+}
+
+void DrawList::draw(InstancedBatch &batch, const glm::mat4 &model) {
+    if (meshes_batch != &batch) {
+        meshes.clear();
+        for (ShapeInstance &shape : shapes) {
+            shape.mesh = meshes.size();
+            for (const Shape::Level &level : shape.shape->get_levels()) {
+                meshes.push_back(batch.add_mesh(level.triangles));
+            }
+        }
+        meshes_batch = &batch;
+    }
+    update_inputs(model);
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        Segment &segment = segments[i];
+        update(i);
+        segment.count = 0;
+        segment.error = 0.0f;
+        segment.computed_shapes = segments[i + 1].shape - segment.shape;
+        for (size_t j = segment.shape; j < segments[i + 1].shape; ++j) {
+            const ShapeInstance &shape = shapes[j];
+            float size;
+            const size_t level = select_level(shape, size);
+            const Shape::Level &tessellation = shape.shape->get_levels()[level];
+            segment.count += tessellation.vertices.size();
+            segment.error = std::max(segment.error, size * tessellation.error);
+            batch.add_instance(meshes[shape.mesh + level], models[shape.transform], shape.color, inputs[shape.glow].last);
+        }
+    }
+}
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "batch.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+namespace visualizer {
+
+class InstancedBatch;
+class Object;
+class Shape;
+
+// The object tree unrolled into a linear list of transforms, each refering
+// to the result of an earlier one, and the shapes drawn with them. Shared
+// subtrees appear once per path. Parameters are kept as pointers, so the
+// tree only needs to be compiled again when its structure changes.
+//
+// The subtree below each transform of the root is independent of the
+// others, so the list is cut into segments there. Segments can be drawn by
+// different threads, each into its own range of the batch, which is known
+// in advance because the number of vertices of every shape is fixed.
+//
+// Every value the list reads gets a version that changes only when the
+// value does, and every model matrix one that changes when it's recomputed.
+// A matrix is only recomputed when the version of its parent or one of its
+// values changed, and the transformed vertices of a shape are kept until
+// the version of its matrix or glow changes.
+//
+// Once the view is known, shapes with several levels of tessellation are
+// drawn with the coarsest one good enough for their projected size. The
+// vertices of a shape are cached with room for its finest level, so the
+// cache never needs to grow, and are packed when copied into the batch.
+// The indices are copied from the level with the place of the shape in the
+// batch added. Each segment gets its room in the batch at once, unless it's
+// too large for a chunk of the batch, when each of its shapes gets its own.
+class DrawList {
+public:
+    static const size_t ROOT = 0;
+
+    explicit DrawList(const Object &root);
+
+    size_t add_scale(size_t parent, const float &x, const float &y);
+    size_t add_rotate(size_t parent, const float &degree);
+    size_t add_translate(size_t parent, const glm::vec3 &direction, const float *z);
+    size_t add_ring_slot(size_t parent, float degree, float radius);
+    void add_shape(size_t parent, const Shape &shape, const float &glow);
+
+    // The projection and view the vertices are drawn with, and the height of
+    // the viewport in pixels.
+    void set_view(const glm::mat4 &projection, const glm::mat4 &view, int viewport_size);
+
+    size_t get_num_transforms() const { return transforms.size(); }
+    size_t get_num_shapes() const { return shapes.size(); }
+    size_t get_num_segments() const { return segments.size() - 1; }
+    // The share of matrices and shapes of the last draw that were cached.
+    float get_transform_hit_rate() const;
+    float get_shape_hit_rate() const;
+    // The number of vertices and the largest deviation of a tessellated
+    // outline in pixels of the last draw.
+    size_t get_num_vertices() const;
+    float get_max_error() const;
+
+    void draw(Batch &batch, const glm::mat4 &model);
+    void draw(Batch &batch, const glm::mat4 &model, ThreadPool &pool);
+    void draw(InstancedBatch &batch, const glm::mat4 &model);
+
+private:
+    enum class Op {
+        SCALE,
+        ROTATE,
+        TRANSLATE,
+        RING_SLOT
+    };
+
+    static const size_t NONE;
+
+    struct Input {
+        const float *value;
+        float last;
+        unsigned int version;
+        bool angle;
+        float cos;
+        float sin;
+    };
+
+    // a and b are indices of inputs, the versions those seen when the matrix
+    // was last computed.
+    struct Transform {
+        Op op;
+        size_t parent;
+        size_t a;
+        size_t b;
+        glm::vec3 constant;
+        unsigned int parent_version;
+        unsigned int a_version;
+        unsigned int b_version;
+    };
+
+    // The level is the one the cached vertices were transformed with. The
+    // meshes of the levels start at meshes[mesh].
+    struct ShapeInstance {
+        size_t transform;
+        glm::vec3 color;
+        size_t glow;
+        const Shape *shape;
+        size_t level;
+        float error;
+        size_t mesh;
+        size_t offset;
+        unsigned int transform_version;
+        unsigned int glow_version;
+    };
+
+    // The first transform, shape and cached vertex of a segment, whether all
+    // of its shapes have a single level, and what it took in the last draw.
+    // A last entry marks the end of the list.
+    struct Segment {
+        size_t transform;
+        size_t shape;
+        size_t vertex;
+        bool fixed;
+        size_t count;
+        size_t index_count;
+        float error;
+        size_t computed_transforms;
+        size_t computed_shapes;
+    };
+
+    std::vector<Input> inputs;
+    std::vector<Transform> transforms;
+    std::vector<ShapeInstance> shapes;
+    std::vector<glm::mat4> models;
+    std::vector<unsigned int> versions;
+    std::vector<Batch::Vertex> vertices;
+    std::vector<Segment> segments;
+    // The room of each segment in the batch, or of each shape if its segment
+    // has none.
+    std::vector<Batch::Range> ranges;
+    std::vector<Batch::Range> shape_ranges;
+    // Indices of segments, splitting them into chunks of about the same work
+    // for chunks_threads threads.
+    std::vector<size_t> chunks;
+    size_t chunks_threads;
+    size_t num_vertices;
+    std::vector<size_t> meshes;
+    const InstancedBatch *meshes_batch;
+    bool has_view;
+    glm::mat4 view_projection;
+    float pixels_per_unit;
+
+    size_t add_input(const float &value, bool angle = false);
+    size_t add_transform(Op op, size_t parent, size_t a, size_t b, const glm::vec3 &constant);
+    void split(size_t num_threads);
+    void update_inputs(const glm::mat4 &model);
+    void update(size_t segment);
+    size_t select_level(const ShapeInstance &shape, float &size) const;
+    void transform(const Batch &batch, size_t segment);
+    void place(Batch &batch);
+    void copy(size_t segment) const;
+};
+
+}
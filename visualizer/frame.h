@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+namespace visualizer {
+
+// The uniforms shared by the programs, laid out as the Frame block of the
+// shaders with std140. It's uploaded once per frame into a uniform buffer
+// bound to BINDING, and every program has its block bound there.
+struct Frame {
+    static const GLuint BINDING = 0;
+
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 light;
+    GLfloat measure;
+    GLfloat exposure;
+    GLfloat gamma;
+    GLfloat padding[2];
+};
+
+static_assert(sizeof(Frame) == 160, "Frame must match the std140 layout of the block");
+
+}
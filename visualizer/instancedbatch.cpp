@@ -0,0 +1,100 @@
+#include "instancedbatch.h"
+
+#include <cstddef>
+
+namespace visualizer {
+
+const int InstancedBatch::ATTRIBUTE_POSITION = 0;
+const int InstancedBatch::ATTRIBUTE_COLOR = 1;
+const int InstancedBatch::ATTRIBUTE_GLOW = 2;
+const int InstancedBatch::ATTRIBUTE_MODEL = 3;
+
+InstancedBatch::InstancedBatch() {
+    auto binding = vao.bind();
+    binding.enable_attribute(ATTRIBUTE_POSITION);
+    binding.enable_attribute(ATTRIBUTE_COLOR);
+    binding.enable_attribute(ATTRIBUTE_GLOW);
+    binding.attribute_divisor(ATTRIBUTE_COLOR, 1);
+    binding.attribute_divisor(ATTRIBUTE_GLOW, 1);
+    for (int i = 0; i < 4; ++i) {
+        binding.enable_attribute(ATTRIBUTE_MODEL + i);
+        binding.attribute_divisor(ATTRIBUTE_MODEL + i, 1);
+    }
+}
+
+// Shapes with the same triangles share one mesh, whichever object they
+// belong to.
+size_t InstancedBatch::add_mesh(const std::vector<glm::mat4> &triangles) {
+    std::vector<GLfloat> positions;
+    for (const glm::mat4 &triangle : triangles) {
+        for (int i = 0; i < 3; ++i) {
+            positions.push_back(triangle[i].x);
+            positions.push_back(triangle[i].y);
+            positions.push_back(triangle[i].z);
+        }
+    }
+    const size_t mesh = meshes.add(positions);
+    mesh_instances.resize(meshes.get_num_meshes());
+    return mesh;
+}
+
+void InstancedBatch::add_instance(size_t mesh, const glm::mat4 &model, const glm::vec3 &color, float glow) {
+    mesh_instances[mesh].push_back({ model, color, glow });
+}
+
+size_t InstancedBatch::get_num_instances() const {
+    size_t count = 0;
+    for (const auto &instances : mesh_instances) {
+        count += instances.size();
+    }
+    return count;
+}
+
+size_t InstancedBatch::get_num_vertices() const {
+    size_t count = 0;
+    for (size_t i = 0; i < mesh_instances.size(); ++i) {
+        count += meshes.get(i).count * mesh_instances[i].size();
+    }
+    return count;
+}
+
+void InstancedBatch::clear() {
+    for (auto &instances : mesh_instances) {
+        instances.clear();
+    }
+}
+
+void InstancedBatch::draw() {
+    auto binding = vao.bind();
+    meshes.bind(binding, ATTRIBUTE_POSITION);
+
+    instances.clear();
+    for (const auto &mesh : mesh_instances) {
+        instances.insert(instances.end(), mesh.begin(), mesh.end());
+    }
+    if (instances.empty()) {
+        return;
+    }
+
+    auto index_binding = meshes.bind_indices();
+    auto buffer_binding = instance_buffer.bind(GL_ARRAY_BUFFER);
+    buffer_binding.data(instances.size() * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    buffer_binding.subdata(0, instances.size() * sizeof(Instance), instances.data());
+    size_t offset = 0;
+    for (size_t mesh = 0; mesh < mesh_instances.size(); ++mesh) {
+        const size_t count = mesh_instances[mesh].size();
+        if (count == 0) {
+            continue;
+        }
+        const char *base = reinterpret_cast<const char *>(offset * sizeof(Instance));
+        for (int i = 0; i < 4; ++i) {
+            buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_MODEL + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), base + offsetof(Instance, model) + i * sizeof(glm::vec4));
+        }
+        buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), base + offsetof(Instance, color));
+        buffer_binding.vertex_attrib_pointer(binding, ATTRIBUTE_GLOW, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), base + offsetof(Instance, glow));
+        meshes.draw_instanced(mesh, static_cast<GLsizei>(count));
+        offset += count;
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <buffer.h>
+#include <meshregistry.h>
+#include <vertexarray.h>
+
+#include <vector>
+
+namespace visualizer {
+
+class InstancedBatch {
+public:
+    static const int ATTRIBUTE_POSITION;
+    static const int ATTRIBUTE_COLOR;
+    static const int ATTRIBUTE_GLOW;
+    static const int ATTRIBUTE_MODEL;
+
+    InstancedBatch();
+
+    size_t add_mesh(const std::vector<glm::mat4> &triangles);
+    void add_instance(size_t mesh, const glm::mat4 &model, const glm::vec3 &color, float glow);
+
+    size_t get_num_instances() const;
+    size_t get_num_vertices() const;
+    const MeshRegistry &get_meshes() const { return meshes; }
+
+    void clear();
+    void draw();
+private:
+    struct Instance {
+        glm::mat4 model;
+        glm::vec3 color;
+        float glow;
+    };
+
+    VertexArray vao;
+    Buffer instance_buffer;
+    MeshRegistry meshes;
+    // The instances of each mesh, and all of them as uploaded.
+    std::vector<std::vector<Instance>> mesh_instances;
+    std::vector<Instance> instances;
+};
+
+}
@@ -0,0 +1,253 @@
+#include "nodepool.h"
+
+#include "drawlist.h"
+#include "parameters.h"
+
+#include <nlohmann/json.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace visualizer {
+
+NodePool::NodePool(Parameters &parameters)
+  : parameters(&parameters),
+    root(0),
+    objects(nullptr)
+{ }
+
+NodePool::NodePool(const std::string &filename, Parameters &parameters)
+  : NodePool(parameters)
+{
+    load(filename);
+}
+
+// The path is left as it is when loading fails, so it leads to the node
+// that couldn't be loaded.
+void NodePool::load(const std::string &filename) {
+    nlohmann::json choreography;
+    try {
+        std::ifstream input(filename);
+        choreography = nlohmann::json::parse(input);
+    } catch (const nlohmann::json::parse_error &e) {
+        throw std::runtime_error(std::string("Parse error: ") + e.what());
+    }
+
+    NodePool loaded(*parameters);
+    const nlohmann::json none = nlohmann::json::object();
+    try {
+        const auto &scene = choreography.at("scene");
+        loaded.objects = scene.contains("objects") ? &scene["objects"] : &none;
+        loaded.path.push_back("root");
+        loaded.root = loaded.add_node(scene.at("root"));
+    } catch (const std::exception &e) {
+        std::string path;
+        for (const auto &step : loaded.path) {
+            path += (path.empty() ? "" : "/") + step;
+        }
+        throw std::runtime_error("Invalid scene" + (path.empty() ? "" : " at " + path) + ": " + e.what());
+    }
+    loaded.objects = nullptr;
+    loaded.named.clear();
+    loaded.path.clear();
+    *this = std::move(loaded);
+}
+
+const float &NodePool::get_value(const nlohmann::json &value) {
+    if (value.is_string()) {
+        return parameters->get_parameter(value.get<std::string>());
+    }
+    constants.push_back(value.get<float>());
+    return constants.back();
+}
+
+size_t NodePool::add_named(const std::string &name) {
+    const auto it = named.find(name);
+    if (it != named.end()) {
+        return it->second;
+    }
+    if (std::find(loading.begin(), loading.end(), name) != loading.end()) {
+        throw std::runtime_error("Scene object " + name + " contains itself");
+    }
+    if (!objects->contains(name)) {
+        throw std::runtime_error("Undefined scene object " + name);
+    }
+    loading.push_back(name);
+    path.push_back(name);
+    const size_t node = add_node((*objects)[name]);
+    path.pop_back();
+    loading.pop_back();
+    named.emplace(name, node);
+    return node;
+}
+
+// The children are added first, so that the indices of a node's children
+// are contiguous even when they are shared.
+size_t NodePool::add_children(const nlohmann::json &descriptions, Node node) {
+    std::vector<size_t> added;
+    for (const auto &description : descriptions) {
+        path.push_back(std::to_string(added.size()));
+        added.push_back(add_node(description));
+        path.pop_back();
+    }
+    node.begin = children.size();
+    node.end = children.size() + added.size();
+    children.insert(children.end(), added.begin(), added.end());
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+size_t NodePool::add_node(const nlohmann::json &description) {
+    if (description.is_string()) {
+        return add_named(description.get<std::string>());
+    }
+    if (description.size() != 1) {
+        throw std::runtime_error("Scene nodes must have exactly one type: " + description.dump());
+    }
+    const std::string type = description.begin().key();
+    const auto &properties = description.begin().value();
+    path.push_back(type);
+
+    Node node{ Type::COLLECTION, 0, 0, nullptr, nullptr, glm::vec2(0.0f), 0, 0.0f };
+    if (type == "triangle" || type == "rectangle" || type == "circle") {
+        const auto color = properties.at("color");
+        const glm::vec3 rgb(color.at(0).get<float>(), color.at(1).get<float>(), color.at(2).get<float>());
+        const float &glow = get_value(properties.at("glow"));
+        if (type == "triangle") {
+            shapes.push_back(Triangle(rgb, glow));
+        } else if (type == "rectangle") {
+            shapes.push_back(Rectangle(rgb, glow));
+        } else {
+            shapes.push_back(Circle(rgb, glow));
+        }
+        node.type = Type::SHAPE;
+        node.begin = shapes.size() - 1;
+        nodes.push_back(node);
+        path.pop_back();
+        return nodes.size() - 1;
+    } else if (type == "scale") {
+        node.type = Type::SCALE;
+        node.a = &get_value(properties.at("factor"));
+    } else if (type == "deform") {
+        node.type = Type::DEFORM;
+        node.a = &get_value(properties.at("width"));
+        node.b = &get_value(properties.at("height"));
+    } else if (type == "rotate") {
+        node.type = Type::ROTATE;
+        node.a = &get_value(properties.at("degree"));
+    } else if (type == "translate") {
+        node.type = Type::TRANSLATE;
+        node.offset = glm::vec2(properties.value("x", 0.0f), properties.value("y", 0.0f));
+        node.a = &get_value(properties.contains("z") ? properties["z"] : nlohmann::json(0.0f));
+    } else if (type == "ring") {
+        node.type = Type::RING;
+        node.num_repetitions = properties.at("repetitions").get<unsigned int>();
+        node.radius = properties.at("radius").get<float>();
+    } else if (type != "collection") {
+        throw std::runtime_error("Unknown scene node type " + type);
+    }
+    size_t index;
+    if (type == "ring") {
+        index = add_children(properties.at("objects"), node);
+    } else if (type == "collection") {
+        index = add_children(properties, node);
+    } else {
+        index = add_children(nlohmann::json::array({ properties.at("object") }), node);
+    }
+    path.pop_back();
+    return index;
+}
+
+void NodePool::draw(Batch &batch, const glm::mat4 &model) const {
+    if (!nodes.empty()) {
+        draw(root, batch, model);
+    }
+}
+
+void NodePool::compile(DrawList &list, size_t parent) const {
+    if (!nodes.empty()) {
+        compile(root, list, parent);
+    }
+}
+
+// Both traversals follow the object classes step by step, so that a scene
+// described in the choreography gives the same vertices as the same scene
+// built from them.
+void NodePool::draw(size_t index, Batch &batch, const glm::mat4 &model) const {
+    const Node &node = nodes[index];
+    switch (node.type) {
+    case Type::SHAPE:
+        shapes[node.begin].draw(batch, model);
+        return;
+    case Type::SCALE:
+        draw(children[node.begin], batch, glm::scale(model, glm::vec3(*node.a, *node.a, 1.0f)));
+        return;
+    case Type::DEFORM:
+        draw(children[node.begin], batch, glm::scale(model, glm::vec3(*node.a, *node.b, 1.0f)));
+        return;
+    case Type::ROTATE:
+        draw(children[node.begin], batch, glm::rotate(model, glm::radians(*node.a), glm::vec3(0.0f, 0.0f, 1.0f)));
+        return;
+    case Type::TRANSLATE:
+        draw(children[node.begin], batch, glm::translate(model, glm::vec3(node.offset.x, node.offset.y, *node.a)));
+        return;
+    case Type::RING: {
+        const size_t num_objects = node.end - node.begin;
+        const float angle = 360.0f / (node.num_repetitions * num_objects);
+        for (unsigned int i = 0; i < node.num_repetitions; ++i) {
+            for (size_t j = 0; j < num_objects; ++j) {
+                glm::mat4 rotation = glm::rotate(model, glm::radians(angle * (j + num_objects * i)), glm::vec3(0.0f, 0.0f, 1.0f));
+                rotation = glm::translate(rotation, glm::vec3(0.0f, node.radius, 0.0f));
+                draw(children[node.begin + j], batch, rotation);
+            }
+        }
+        return;
+    }
+    case Type::COLLECTION:
+        for (size_t i = node.begin; i < node.end; ++i) {
+            draw(children[i], batch, model);
+        }
+        return;
+    }
+}
+
+void NodePool::compile(size_t index, DrawList &list, size_t parent) const {
+    const Node &node = nodes[index];
+    switch (node.type) {
+    case Type::SHAPE:
+        shapes[node.begin].compile(list, parent);
+        return;
+    case Type::SCALE:
+        compile(children[node.begin], list, list.add_scale(parent, *node.a, *node.a));
+        return;
+    case Type::DEFORM:
+        compile(children[node.begin], list, list.add_scale(parent, *node.a, *node.b));
+        return;
+    case Type::ROTATE:
+        compile(children[node.begin], list, list.add_rotate(parent, *node.a));
+        return;
+    case Type::TRANSLATE:
+        compile(children[node.begin], list, list.add_translate(parent, glm::vec3(node.offset.x, node.offset.y, 0.0f), node.a));
+        return;
+    case Type::RING: {
+        const size_t num_objects = node.end - node.begin;
+        const float angle = 360.0f / (node.num_repetitions * num_objects);
+        for (unsigned int i = 0; i < node.num_repetitions; ++i) {
+            for (size_t j = 0; j < num_objects; ++j) {
+                compile(children[node.begin + j], list, list.add_ring_slot(parent, angle * (j + num_objects * i), node.radius));
+            }
+        }
+        return;
+    }
+    case Type::COLLECTION:
+        for (size_t i = node.begin; i < node.end; ++i) {
+            compile(children[i], list, parent);
+        }
+        return;
+    }
+}
+
+}
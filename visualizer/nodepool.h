@@ -0,0 +1,89 @@
+#pragma once
+
+#include "object.h"
+#include "shape.h"
+
+#include <nlohmann/json_fwd.hpp>
+
+#include <glm/vec2.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace visualizer {
+
+class Parameters;
+
+// The scene graph described by the "scene" section of a choreography. All
+// nodes live in one vector and refer to their children by index, so the
+// graph is a few flat arrays instead of a heap allocation per node. Named
+// objects can be used several times, like a shared_ptr in a hand-written
+// scene.
+class NodePool : public Object {
+public:
+    NodePool(const std::string &filename, Parameters &parameters);
+
+    // Replaces the graph with the one from the file. If the file can't be
+    // parsed or the scene is invalid, the old graph is kept and a
+    // std::runtime_error tells where.
+    void load(const std::string &filename);
+
+    size_t get_num_nodes() const { return nodes.size(); }
+
+    void draw(Batch &batch, const glm::mat4 &model) const override;
+    void compile(DrawList &list, size_t parent) const override;
+
+private:
+    enum class Type {
+        SHAPE,
+        SCALE,
+        DEFORM,
+        ROTATE,
+        TRANSLATE,
+        RING,
+        COLLECTION
+    };
+
+    // The children of a node are children[begin] to children[end - 1]; a
+    // shape refers to shapes[begin] instead. Parameters and constants are
+    // kept as pointers like in the object classes.
+    struct Node {
+        Type type;
+        size_t begin;
+        size_t end;
+        const float *a;
+        const float *b;
+        glm::vec2 offset;
+        unsigned int num_repetitions;
+        float radius;
+    };
+
+    explicit NodePool(Parameters &parameters);
+
+    Parameters *parameters;
+    std::vector<Node> nodes;
+    std::vector<size_t> children;
+    std::vector<Shape> shapes;
+    std::deque<float> constants;
+    size_t root;
+
+    // Used while loading only.
+    const nlohmann::json *objects;
+    std::map<std::string, size_t> named;
+    std::vector<std::string> loading;
+    // The node types, child indices and object names leading to the node
+    // being loaded.
+    std::vector<std::string> path;
+
+    size_t add_node(const nlohmann::json &description);
+    size_t add_named(const std::string &name);
+    size_t add_children(const nlohmann::json &descriptions, Node node);
+    const float &get_value(const nlohmann::json &value);
+
+    void draw(size_t node, Batch &batch, const glm::mat4 &model) const;
+    void compile(size_t node, DrawList &list, size_t parent) const;
+};
+
+}
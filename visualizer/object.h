@@ -2,14 +2,18 @@
 
 #include <glm/mat4x4.hpp>
 
+#include <cstddef>
+
 namespace visualizer {
 
 class Batch;
+class DrawList;
 
 class Object {
 public:
     virtual ~Object() = default;
     virtual void draw(Batch &batch, const glm::mat4 &model) const = 0;
+    virtual void compile(DrawList &list, size_t parent) const = 0;
 };
 
 }
@@ -4,8 +4,9 @@
 
 namespace visualizer {
 
-Parameter::Parameter(const nlohmann::json &actions)
-  : value(0.0f)
+Parameter::Parameter(const nlohmann::json &actions, const ActionContext &context)
+  : context(&context),
+    value(0.0f)
 {
     load(actions);
 }
@@ -14,7 +15,7 @@ void Parameter::load(const nlohmann::json &actions) {
     this->actions.clear();
     for (const auto &item : actions.items()) {
         const float time = std::stof(item.key());
-        this->actions.emplace_back(create_action(time, item.value()));
+        this->actions.emplace_back(create_action(time, item.value(), *context));
     }
 }
 
@@ -11,7 +11,7 @@ namespace visualizer {
 
 class Parameter {
 public:
-    explicit Parameter(const nlohmann::json &actions);
+    Parameter(const nlohmann::json &actions, const ActionContext &context);
     void load(const nlohmann::json &actions);
     void clear();
 
@@ -20,6 +20,7 @@ public:
 
 private:
     using Actions = std::vector<std::unique_ptr<Action>>;
+    const ActionContext *context;
     Actions actions;
     float value;
 };
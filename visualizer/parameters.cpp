@@ -12,7 +12,10 @@
 
 namespace visualizer {
 
-Parameters::Parameters(const std::string &filename) : debugged(parameters.end()) {
+Parameters::Parameters(const std::string &filename)
+  : context{ 0.0f, 0.0f, nullptr },
+    debugged(parameters.end())
+{
     load(filename);
 }
 
@@ -33,14 +36,15 @@ void Parameters::load(const std::string &filename) {
             meter_num = std::stoi(meter.substr(0, slash));
             meter_denum = std::stoi(meter.substr(slash + 1));
         }
-        ms_per_measure = static_cast<float>(meter_num) * 60000.0f / bpm;
+        context.ms_per_measure = static_cast<float>(meter_num) * 60000.0f / bpm;
+        context.offset = general.value("offset", 0.0f);
 
         const auto parameters = choreography["parameters"];
         for (const auto &entry : parameters.items()) {
             const std::string name = entry.key();
             const auto it = this->parameters.find(name);
             if (it == this->parameters.end()) {
-                this->parameters.emplace(name, Parameter(entry.value()));
+                this->parameters.emplace(name, Parameter(entry.value(), context));
             } else {
                 it->second.load(entry.value());
             }
@@ -70,6 +74,13 @@ void Parameters::set_measure(float measure) {
     if (debugging) {
         debug_output << '\n';
     }
+    for (auto &entry : inputs) {
+        entry.second.value = entry.second.source->load(std::memory_order_acquire);
+    }
+}
+
+void Parameters::set_feature_cache(const FeatureCache *features) {
+    context.features = features;
 }
 
 void Parameters::set_debug_output(const std::string &filename) {
@@ -82,10 +93,21 @@ void Parameters::set_debug_output(const std::string &filename) {
     debug_output << '\n';
 }
 
+void Parameters::add_input(const std::string &name, const std::atomic<float> &source) {
+    if (parameters.find(name) != parameters.end()) {
+        throw std::runtime_error("Input " + name + " shadows a parameter");
+    }
+    inputs[name] = Input{ &source, source.load() };
+}
+
 const float &Parameters::get_parameter(const std::string &name) {
     const auto it = parameters.find(name);
     if (it == parameters.end()) {
-        throw std::runtime_error("Undefined parameter " + name);
+        const auto input = inputs.find(name);
+        if (input == inputs.end()) {
+            throw std::runtime_error("Undefined parameter " + name);
+        }
+        return input->second.value;
     }
     return it->second.get_value();
 }
@@ -2,6 +2,7 @@
 
 #include "parameter.h"
 
+#include <atomic>
 #include <fstream>
 #include <istream>
 #include <map>
@@ -24,17 +25,27 @@ public:
     void set_debug_output(const std::string &filename);
 
     void add_action(const std::string &name, std::unique_ptr<Action> action);
+    void add_input(const std::string &name, const std::atomic<float> &source);
 
     const float &get_parameter(const std::string &name);
 
-    float get_ms_per_measure() const { return ms_per_measure; }
+    float get_ms_per_measure() const { return context.ms_per_measure; }
+    float get_offset() const { return context.offset; }
+    void set_feature_cache(const FeatureCache *features);
 
     void choose_debugged_parameter();
     void plot_debugger_parameter(float measure, float around, int count);
 private:
+    struct Input {
+        const std::atomic<float> *source;
+        float value;
+    };
+    using InputMap = std::map<std::string, Input>;
+
     std::ofstream debug_output;
-    float ms_per_measure;
+    ActionContext context;
     ParameterMap parameters;
+    InputMap inputs;
     ParameterMap::iterator debugged;
 };
 
@@ -10,11 +10,11 @@ PostProcessing::PostProcessing(GLsizei width, GLsizei height)
     {
         auto binding = texture.bind(GL_TEXTURE0, GL_TEXTURE_2D);
         binding.image_2d(0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        binding.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        binding.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
+    texture.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    texture.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texture.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    texture.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     {
         auto binding = framebuffer.bind(GL_FRAMEBUFFER);
         binding.attach(GL_COLOR_ATTACHMENT0, texture, 0);
@@ -1,5 +1,7 @@
 #include "ring.h"
 
+#include "drawlist.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace visualizer {
@@ -24,4 +26,14 @@ void Ring::draw(Batch &batch, const glm::mat4 &model) const {
     }
 }
 
+void Ring::compile(DrawList &list, size_t parent) const {
+    const auto num_objects = objects.size();
+    const float angle = 360.0f / (num_repetitions * num_objects);
+    for (unsigned int i = 0; i < num_repetitions; ++i) {
+        for (size_t j = 0; j < num_objects; ++j) {
+            objects[j]->compile(list, list.add_ring_slot(parent, angle * (j + num_objects * i), radius));
+        }
+    }
+}
+
 }
@@ -13,6 +13,7 @@ public:
          std::initializer_list<std::shared_ptr<Object>> objects);
 
     void draw(Batch &batch, const glm::mat4 &model) const override;
+    void compile(DrawList &list, size_t parent) const override;
 
 private:
     unsigned int num_repetitions;
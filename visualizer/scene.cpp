@@ -11,19 +11,19 @@ Scene::Scene(GLsizei width, GLsizei height)
     {
         auto binding = color.bind(GL_TEXTURE0, GL_TEXTURE_2D);
         binding.image_2d(0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        binding.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        binding.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
+    color.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    color.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    color.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    color.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     {
         auto binding = glow.bind(GL_TEXTURE0, GL_TEXTURE_2D);
         binding.image_2d(0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        binding.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        binding.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        binding.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
+    glow.set_parameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glow.set_parameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glow.set_parameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glow.set_parameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     {
         auto binding = depth.bind(GL_RENDERBUFFER);
         binding.storage(GL_DEPTH_COMPONENT, width, height);
@@ -6,10 +6,17 @@ in float vertex_glow;
 out vec4 color;
 out vec4 glow;
 
-uniform vec3 light;
+layout(std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 light;
+    float measure;
+    float exposure;
+    float gamma;
+} frame;
 
 void main() {
-    float diff = max(normalize(light - vertex_position).z, 0);
+    float diff = max(normalize(frame.light - vertex_position).z, 0);
     color = vec4((vertex_glow + 0.05) * diff * vertex_color, 1.0);
     glow = vec4(vertex_glow * vertex_color, 1.0);
     //color = vec4(1.0, 1.0, 1.0, 1.0);
@@ -1,20 +1,26 @@
 #version 330 core
 in vec3 position;
-in vec3 color;
+in vec4 color;
 in float glow;
 
 out vec3 vertex_position;
 out vec3 vertex_color;
 out float vertex_glow;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout(std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 light;
+    float measure;
+    float exposure;
+    float gamma;
+} frame;
 
 void main() {
-    vertex_color = color;
+    vertex_color = color.rgb;
     vertex_position = position;
     vertex_glow = glow;
-    gl_Position = projection * view * vec4(position, 1.0);
+    gl_Position = frame.projection * frame.view * vec4(position, 1.0);
     /*if (gl_VertexID == 0) {
         gl_Position = vec4(-0.5, -0.5, 0.0, 1.0);
         //gl_Position = vec4(position, 1.0);
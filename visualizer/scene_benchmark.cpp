@@ -0,0 +1,328 @@
+#include <GL/glew.h>
+#include <SDL.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+#include "collection.h"
+#include "drawlist.h"
+#include "instancedbatch.h"
+#include "nodepool.h"
+#include "parameters.h"
+#include "ring.h"
+#include "shape.h"
+#include "transform.h"
+
+#include <threadpool.h>
+
+namespace {
+
+// Each group is a rotating ring like the ones of the choreography, which
+// makes 43 nodes per group when the ring is unrolled.
+const size_t NUM_GROUPS = 233;
+const unsigned int NUM_REPETITIONS = 5;
+
+float angle = 15.0f;
+float width = 1.0f;
+float height = 0.5f;
+float scale = 0.3f;
+float glow = 1.0f;
+float z = 0.0f;
+
+std::shared_ptr<visualizer::Object> create_group(size_t i) {
+    auto ring = std::make_shared<visualizer::Ring>(NUM_REPETITIONS, 1.0f, std::initializer_list<std::shared_ptr<visualizer::Object>>{
+        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Triangle>(glm::vec3(1.0f, 1.0f, 0.0f), glow), width, height), scale), angle),
+        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Triangle>(glm::vec3(1.0f, 0.0f, 0.0f), glow), height, width), scale), angle)});
+    return std::make_shared<visualizer::Translate>(std::make_shared<visualizer::Rotate>(ring, angle), 0.01f * i, 0.0f, z);
+}
+
+// Compares the vertices of the triangles of a batch in the order they are
+// drawn, independently of how it's indexed and split into chunks. The batch
+// has to be cleared afterwards.
+bool is_same(const std::vector<visualizer::Batch::Vertex> &expected, visualizer::Batch &batch) {
+    const std::vector<visualizer::Batch::Vertex> contents = batch.read_back();
+    return expected.size() == contents.size()
+        && memcmp(expected.data(), contents.data(), expected.size() * sizeof(visualizer::Batch::Vertex)) == 0;
+}
+
+// The bytes the batch would take with seven floats per vertex and without
+// indices.
+size_t get_unpacked_size(const visualizer::Batch &batch) {
+    return batch.get_num_indices() * 7 * sizeof(GLfloat);
+}
+
+const char *get_name(visualizer::Batch::Kernel kernel) {
+    switch (kernel) {
+    case visualizer::Batch::Kernel::SCALAR:
+        return "scalar";
+    case visualizer::Batch::Kernel::SSE:
+        return "SSE";
+    case visualizer::Batch::Kernel::AVX:
+        return "AVX";
+    }
+    return "";
+}
+
+// Transforms random triangles with random matrices once through
+// add_triangle(model * triangle) and once through add_vertices() with the
+// given kernel, and compares the vertices.
+bool check_kernel(visualizer::Batch &batch, visualizer::Batch::Kernel kernel) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+    auto random_vec4 = [&](float w) { return glm::vec4(distribution(generator), distribution(generator), distribution(generator), w); };
+
+    std::vector<glm::mat4> triangles;
+    std::vector<glm::vec4> vertices;
+    std::vector<visualizer::Batch::Index> indices;
+    for (int i = 0; i < 5; ++i) {
+        const glm::mat4 t(random_vec4(1.0f), random_vec4(1.0f), random_vec4(1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        triangles.push_back(t);
+        for (int j = 0; j < 3; ++j) {
+            indices.push_back(static_cast<visualizer::Batch::Index>(vertices.size()));
+            vertices.push_back(t[j]);
+        }
+    }
+
+    bool same = true;
+    batch.set_kernel(kernel);
+    for (int i = 0; i < 100 && same; ++i) {
+        const glm::mat4 model(random_vec4(0.0f), random_vec4(0.0f), random_vec4(0.0f), random_vec4(1.0f));
+        const glm::vec3 color(random_vec4(0.0f));
+        const float glow = distribution(generator);
+
+        batch.clear();
+        for (const auto &t : triangles) {
+            batch.add_triangle(model * t, color, glow);
+        }
+        const std::vector<visualizer::Batch::Vertex> expected = batch.read_back();
+        batch.clear();
+        batch.add_vertices(model, vertices, indices, color, glow);
+        same = is_same(expected, batch);
+    }
+    return same;
+}
+
+// Changes the angle of all rotations, so that nothing can be taken from the
+// caches of the draw list.
+void animate() {
+    angle = angle == 15.0f ? 16.0f : 15.0f;
+}
+
+template<typename Draw>
+double measure(int iterations, Draw draw) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        draw();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+
+// Compares the fixed tessellation of the circle with the one chosen by
+// projected size, for a circle at several sizes and over the scene of a
+// choreography.
+void measure_tessellation(const char *choreography) {
+    const int viewport = 800;
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+    visualizer::Batch batch;
+
+    float circle_scale = 1.0f;
+    const visualizer::Scale circle(std::make_shared<visualizer::Circle>(glm::vec3(1.0f), glow), circle_scale);
+    const float default_error = 1.0f - std::cos(glm::radians(180.0f / 16));
+    for (float s : { 0.01f, 0.1f, 1.0f, 4.0f }) {
+        circle_scale = s;
+        visualizer::DrawList fixed(circle);
+        visualizer::DrawList adaptive(circle);
+        adaptive.set_view(projection, view, viewport);
+        batch.clear();
+        fixed.draw(batch, model);
+        batch.clear();
+        adaptive.draw(batch, model);
+        const float radius = 0.5f * s * projection[1][1] * viewport / 2.0f / 5.0f;
+        std::cout << "Circle of " << radius << " pixels: " << fixed.get_num_vertices() << " vertices with an error of "
+                  << radius * default_error << " pixels fixed, " << adaptive.get_num_vertices() << " vertices with an error of "
+                  << adaptive.get_max_error() << " pixels adaptive\n";
+    }
+
+    if (choreography == nullptr) {
+        return;
+    }
+    visualizer::Parameters parameters(choreography);
+    const visualizer::NodePool scene(choreography, parameters);
+    visualizer::DrawList fixed(scene);
+    visualizer::DrawList adaptive(scene);
+    adaptive.set_view(projection, view, viewport);
+    size_t fixed_vertices = 0;
+    size_t adaptive_vertices = 0;
+    size_t packed_size = 0;
+    size_t unpacked_size = 0;
+    float max_error = 0.0f;
+    int frames = 0;
+    for (float measure = 0.0f; measure < 64.0f; measure += 1.0f / 16.0f, ++frames) {
+        parameters.set_measure(measure);
+        batch.clear();
+        fixed.draw(batch, model);
+        fixed_vertices += fixed.get_num_vertices();
+        batch.clear();
+        adaptive.draw(batch, model);
+        adaptive_vertices += adaptive.get_num_vertices();
+        packed_size += batch.get_size();
+        unpacked_size += get_unpacked_size(batch);
+        max_error = std::max(max_error, adaptive.get_max_error());
+    }
+    std::cout << choreography << ": " << static_cast<double>(fixed_vertices) / frames << " vertices per frame fixed, "
+              << static_cast<double>(adaptive_vertices) / frames << " adaptive with a maximal error of " << max_error << " pixels, "
+              << static_cast<double>(packed_size) / frames << " bytes per frame instead of " << static_cast<double>(unpacked_size) / frames << "\n";
+}
+
+// Draws a million triangles, many more than fit into a chunk of the batch,
+// once cut into a segment per ring and once as a single segment, and checks
+// the number of vertices.
+bool measure_million(const glm::mat4 &model) {
+    const unsigned int num_rings = 1000;
+    const unsigned int num_triangles = 1000;
+    const size_t expected_vertices = 3 * num_rings * num_triangles;
+    const auto ring = std::make_shared<visualizer::Ring>(num_triangles, 0.5f, std::initializer_list<std::shared_ptr<visualizer::Object>>{
+        std::make_shared<visualizer::Triangle>(glm::vec3(1.0f, 1.0f, 0.0f), glow)});
+    const auto rings = std::make_shared<visualizer::Ring>(num_rings, 1.0f, std::initializer_list<std::shared_ptr<visualizer::Object>>{ ring });
+    const visualizer::Translate single(rings, 0.0f, 0.0f, z);
+    visualizer::DrawList segmented(*rings);
+    visualizer::DrawList unsegmented(single);
+    visualizer::Batch batch;
+
+    batch.clear();
+    rings->draw(batch, model);
+    const std::vector<visualizer::Batch::Vertex> expected = batch.read_back();
+    bool correct = batch.get_num_vertices() == expected_vertices && expected.size() == expected_vertices;
+    const double segmented_time = measure(10, [&] { batch.clear(); segmented.draw(batch, model); });
+    correct = correct && batch.get_num_vertices() == expected_vertices && is_same(expected, batch);
+    const double unsegmented_time = measure(10, [&] { batch.clear(); unsegmented.draw(batch, model); });
+    correct = correct && batch.get_num_vertices() == expected_vertices && is_same(expected, batch);
+    std::cout << num_rings * num_triangles << " triangles: " << batch.get_num_vertices() << " vertices and "
+              << batch.get_num_indices() << " indices in " << batch.get_num_chunks() << " chunks, "
+              << (correct ? "correct" : "WRONG") << ", " << segmented_time << " us per frame in "
+              << segmented.get_num_segments() << " segments, " << unsegmented_time << " us in one\n";
+    return correct;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        std::cerr << SDL_GetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_Window *window = SDL_CreateWindow("scene_benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = SDL_GL_CreateContext(window);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        return EXIT_FAILURE;
+    }
+
+    // The checks of the output are reported along with the measurements, and
+    // any of them failing fails the run.
+    bool failed = false;
+    {
+        std::vector<std::shared_ptr<visualizer::Object>> groups;
+        for (size_t i = 0; i < NUM_GROUPS; ++i) {
+            groups.push_back(create_group(i));
+        }
+        const visualizer::Collection collection(groups);
+        visualizer::DrawList draw_list(collection);
+        visualizer::Batch batch;
+        visualizer::InstancedBatch instanced_batch;
+        const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+
+        batch.clear();
+        collection.draw(batch, model);
+        const size_t num_vertices = batch.get_num_vertices();
+        const size_t packed_size = batch.get_size();
+        const size_t unpacked_size = get_unpacked_size(batch);
+        const std::vector<visualizer::Batch::Vertex> expected = batch.read_back();
+        batch.clear();
+        draw_list.draw(batch, model);
+        const bool same = is_same(expected, batch);
+
+        const int iterations = 1000;
+        for (auto kernel : { visualizer::Batch::Kernel::SCALAR, visualizer::Batch::Kernel::SSE, visualizer::Batch::Kernel::AVX }) {
+            if (!visualizer::Batch::is_supported(kernel)) {
+                continue;
+            }
+            const bool correct = check_kernel(batch, kernel);
+            failed = failed || !correct;
+            const double time = measure(iterations, [&] { animate(); batch.clear(); draw_list.draw(batch, model); });
+            std::cout << "Kernel " << get_name(kernel) << ": " << (correct ? "identical" : "DIFFERENT")
+                      << " output, " << time << " us per frame\n";
+        }
+
+        const double recursive = measure(iterations, [&] { animate(); batch.clear(); collection.draw(batch, model); });
+        const double flat = measure(iterations, [&] { animate(); batch.clear(); draw_list.draw(batch, model); });
+        const double instanced = measure(iterations, [&] { animate(); instanced_batch.clear(); draw_list.draw(instanced_batch, model); });
+        angle = 15.0f;
+        const double cached = measure(iterations, [&] { batch.clear(); draw_list.draw(batch, model); });
+        const float transform_hit_rate = draw_list.get_transform_hit_rate();
+        const float shape_hit_rate = draw_list.get_shape_hit_rate();
+        const double deformed = measure(iterations, [&] { width = 3.0f - width; batch.clear(); draw_list.draw(batch, model); });
+        const float deformed_transform_hit_rate = draw_list.get_transform_hit_rate();
+        const float deformed_shape_hit_rate = draw_list.get_shape_hit_rate();
+        width = 1.0f;
+        batch.clear();
+        draw_list.draw(batch, model);
+        const bool cached_same = is_same(expected, batch);
+        failed = failed || !same || !cached_same;
+
+        std::cout << 1 + NUM_GROUPS * (3 + NUM_REPETITIONS * 2 * 4) << " nodes, "
+                  << draw_list.get_num_transforms() << " transforms, " << draw_list.get_num_shapes() << " shapes, "
+                  << num_vertices << " vertices, " << expected.size() << " indices, "
+                  << (same ? "identical" : "DIFFERENT") << " output\n"
+                  << "Packed: " << packed_size << " bytes per frame instead of " << unpacked_size << "\n"
+                  << "Recursive: " << recursive << " us per frame\n"
+                  << "Flattened: " << flat << " us per frame (" << recursive / flat << "x)\n"
+                  << "Instanced: " << instanced << " us per frame, " << instanced_batch.get_num_instances() * 20 * sizeof(GLfloat)
+                  << " bytes uploaded instead of " << packed_size << ", "
+                  << instanced_batch.get_meshes().get_num_meshes() << " static meshes with "
+                  << instanced_batch.get_meshes().get_num_vertices() << " vertices and " << instanced_batch.get_meshes().get_num_indices() << " indices\n"
+                  << "Flattened, nothing changed: " << cached << " us per frame, " << transform_hit_rate * 100.0f << "% of matrices and "
+                  << shape_hit_rate * 100.0f << "% of shapes cached, " << (cached_same ? "identical" : "DIFFERENT") << " output\n"
+                  << "Flattened, width changed: " << deformed << " us per frame, " << deformed_transform_hit_rate * 100.0f << "% of matrices and "
+                  << deformed_shape_hit_rate * 100.0f << "% of shapes cached\n";
+
+        const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+            ThreadPool pool(num_threads);
+            visualizer::DrawList uncached(collection);
+            batch.clear();
+            uncached.draw(batch, model, pool);
+            const bool deterministic = is_same(expected, batch);
+            failed = failed || !deterministic;
+            const double parallel = measure(iterations, [&] { animate(); batch.clear(); draw_list.draw(batch, model, pool); });
+            angle = 15.0f;
+            std::cout << "Parallel, " << num_threads << " threads: " << parallel << " us per frame ("
+                      << flat / parallel << "x), " << (deterministic ? "identical" : "DIFFERENT") << " output\n";
+        }
+    }
+
+    failed = !measure_million(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f))) || failed;
+    measure_tessellation(argc > 1 ? argv[1] : nullptr);
+
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
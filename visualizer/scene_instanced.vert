@@ -0,0 +1,26 @@
+#version 330 core
+in vec3 position;
+in vec3 color;
+in float glow;
+in mat4 model;
+
+out vec3 vertex_position;
+out vec3 vertex_color;
+out float vertex_glow;
+
+layout(std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 light;
+    float measure;
+    float exposure;
+    float gamma;
+} frame;
+
+void main() {
+    vec4 world = model * vec4(position, 1.0);
+    vertex_color = color;
+    vertex_position = world.xyz;
+    vertex_glow = glow;
+    gl_Position = frame.projection * frame.view * world;
+}
@@ -3,8 +3,14 @@ in vec2 vertex_texture_coord;
 
 uniform sampler2D screen_texture;
 uniform sampler2D glow_texture;
-uniform float exposure;
-uniform float gamma;
+layout(std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 light;
+    float measure;
+    float exposure;
+    float gamma;
+} frame;
 
 out vec4 FragColor;
 
@@ -14,7 +20,7 @@ void main() {
     vec3 glow = texture(glow_texture, vertex_texture_coord).rgb;
     color += glow;
     //FragColor = vec4(color, 1.0);
-    vec3 result = vec3(1.0) - exp(-color * exposure);
-    result = pow(result, vec3(1.0 / gamma));
+    vec3 result = vec3(1.0) - exp(-color * frame.exposure);
+    result = pow(result, vec3(1.0 / frame.gamma));
     FragColor = vec4(result, 1.0);
 }
@@ -1,26 +1,70 @@
 #include "shape.h"
 
 #include "batch.h"
+#include "drawlist.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace visualizer {
 
 Shape::Shape(const glm::vec3 &color, const float &glow)
     : Shape(color, glow, {}) { }
 
 Shape::Shape(const glm::vec3 &color, const float &glow, std::initializer_list<glm::mat4> triangles)
-  : color(color), glow(&glow), triangles(triangles)
-{ }
+  : color(color),
+    glow(&glow),
+    levels{{ std::numeric_limits<float>::infinity(), 0.0f, {}, {}, {} }},
+    default_level(0)
+{
+    for (const auto &t : triangles) {
+        add_triangle(t);
+    }
+}
 
 void Shape::draw(Batch &batch, const glm::mat4 &model) const {
-    for (const auto &x : triangles) {
-        batch.add_triangle(model * x, color, *glow);
-    }
+    const Level &level = levels[default_level];
+    batch.add_vertices(model, level.vertices, level.indices, color, *glow);
+}
+
+void Shape::compile(DrawList &list, size_t parent) const {
+    list.add_shape(parent, *this, *glow);
 }
 
 void Shape::add_triangle(const glm::mat4 &t) {
-    triangles.push_back(t);
+    Level &level = levels.back();
+    level.triangles.push_back(t);
+    for (int i = 0; i < 3; ++i) {
+        const auto vertex = std::find(level.vertices.begin(), level.vertices.end(), t[i]);
+        level.indices.push_back(static_cast<GLushort>(vertex - level.vertices.begin()));
+        if (vertex == level.vertices.end()) {
+            level.vertices.push_back(t[i]);
+        }
+    }
+}
+
+size_t Shape::select_level(float size) const {
+    size_t level = 0;
+    while (level + 1 < levels.size() && levels[level].max_size < size) {
+        ++level;
+    }
+    return level;
+}
+
+// Starts a new, finer level, which add_triangle() adds to from then on.
+void Shape::add_level(float max_size, float error) {
+    if (levels.back().triangles.empty()) {
+        levels.back() = { max_size, error, {}, {}, {} };
+    } else {
+        levels.push_back({ max_size, error, {}, {}, {} });
+    }
+}
+
+void Shape::set_default_level(size_t level) {
+    default_level = level;
 }
 
 namespace {
@@ -58,20 +102,37 @@ Rectangle::Rectangle(const glm::vec3 &color, const float &glow)
   : Shape(color, glow, { rectangle_upper_left, rectangle_lower_right })
 { }
 
+namespace {
+
+// The largest deviation from the outline, in pixels, that a level of a
+// curved shape may have at its maximal size.
+const float MAX_ERROR = 0.5f;
+const int MIN_SEGMENTS = 8;
+const int DEFAULT_SEGMENTS = 16;
+const int MAX_SEGMENTS = 256;
+
+}
+
 Circle::Circle(const glm::vec3 &color, const float &glow)
     : Shape(color, glow)
 {
-    const int num = 16;
-    for (int i = 0; i < num; ++i) {
-        const float alpha = glm::radians(i * 360.0f / num);
-        const float beta  = glm::radians((i + 1) * 360.0f / num);
-        const glm::mat4 t(
-            0.0f, 0.0f, 0.0f, 1.0f,
-            0.5f * std::cos(alpha), 0.5f * std::sin(alpha), 0.0f, 1.0f,
-            0.5f * std::cos(beta), 0.5f * std::sin(beta), 0.0f, 1.0f,
-            0.0f, 0.0f, 0.0f, 1.0f
-        );
-        add_triangle(t);
+    for (int num = MIN_SEGMENTS; num <= MAX_SEGMENTS; num *= 2) {
+        const float error = 1.0f - std::cos(glm::radians(180.0f / num));
+        add_level(num < MAX_SEGMENTS ? MAX_ERROR / error : std::numeric_limits<float>::infinity(), error);
+        for (int i = 0; i < num; ++i) {
+            const float alpha = glm::radians(i * 360.0f / num);
+            const float beta  = glm::radians((i + 1) * 360.0f / num);
+            const glm::mat4 t(
+                0.0f, 0.0f, 0.0f, 1.0f,
+                0.5f * std::cos(alpha), 0.5f * std::sin(alpha), 0.0f, 1.0f,
+                0.5f * std::cos(beta), 0.5f * std::sin(beta), 0.0f, 1.0f,
+                0.0f, 0.0f, 0.0f, 1.0f
+            );
+            add_triangle(t);
+        }
+        if (num == DEFAULT_SEGMENTS) {
+            set_default_level(get_levels().size() - 1);
+        }
     }
 }
 
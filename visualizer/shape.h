@@ -2,7 +2,9 @@
 
 #include "object.h"
 
+#include <GL/glew.h>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <vector>
 
@@ -10,16 +12,42 @@ namespace visualizer {
 
 class Shape : public Object {
 public:
+    // One tessellation of a shape. It is good enough up to a projected
+    // radius of max_size pixels, where it deviates from the exact outline by
+    // up to error times that radius.
+    struct Level {
+        float max_size;
+        float error;
+        std::vector<glm::mat4> triangles;
+        // The distinct corners of the triangles, and three indices of them
+        // per triangle.
+        std::vector<glm::vec4> vertices;
+        std::vector<GLushort> indices;
+    };
+
     Shape(const glm::vec3 &color, const float &glow);
     Shape(const glm::vec3 &color, const float &glow, std::initializer_list<glm::mat4> triangles);
 
     void draw(Batch &batch, const glm::mat4 &model) const override;
+    void compile(DrawList &list, size_t parent) const override;
 
     void add_triangle(const glm::mat4 &t);
+
+    const glm::vec3 &get_color() const { return color; }
+
+    // The levels are ordered by size. The default level is drawn when the
+    // projected size isn't known.
+    const std::vector<Level> &get_levels() const { return levels; }
+    size_t get_default_level() const { return default_level; }
+    size_t select_level(float size) const;
+protected:
+    void add_level(float max_size, float error);
+    void set_default_level(size_t level);
 private:
     glm::vec3 color;
     const float *glow;
-    std::vector<glm::mat4> triangles;
+    std::vector<Level> levels;
+    size_t default_level;
 };
 
 class Triangle : public Shape {
@@ -1,5 +1,7 @@
 #include "transform.h"
 
+#include "drawlist.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace visualizer {
@@ -12,6 +14,10 @@ void Transform::draw(Batch &batch, const glm::mat4& model) const {
     object->draw(batch, get_transform(model));
 }
 
+void Transform::compile(DrawList &list, size_t parent) const {
+    object->compile(list, compile_transform(list, parent));
+}
+
 Scale::Scale(std::shared_ptr<Object> object, const float &factor)
   : Transform(object), factor(&factor)
 { }
@@ -20,6 +26,10 @@ glm::mat4 Scale::get_transform(const glm::mat4 &model) const {
     return glm::scale(model, glm::vec3(*factor, *factor, 1.0f));
 }
 
+size_t Scale::compile_transform(DrawList &list, size_t parent) const {
+    return list.add_scale(parent, *factor, *factor);
+}
+
 Deform::Deform(std::shared_ptr<Object> object, const float &width, const float &height)
   : Transform(object),
     width(&width),
@@ -30,6 +40,10 @@ glm::mat4 Deform::get_transform(const glm::mat4& model) const {
     return glm::scale(model, glm::vec3(*width, *height, 1.0f));
 }
 
+size_t Deform::compile_transform(DrawList &list, size_t parent) const {
+    return list.add_scale(parent, *width, *height);
+}
+
 Rotate::Rotate(std::shared_ptr<Object> object, const float &degree)
   : Transform(object),
     degree(&degree)
@@ -39,6 +53,10 @@ glm::mat4 Rotate::get_transform(const glm::mat4 &model) const {
     return glm::rotate(model, glm::radians(*degree), glm::vec3(0.0f, 0.0f, 1.0f));
 }
 
+size_t Rotate::compile_transform(DrawList &list, size_t parent) const {
+    return list.add_rotate(parent, *degree);
+}
+
 Translate::Translate(std::shared_ptr<Object> object, const glm::vec3 &direction)
   : Transform(object),
     x(direction.x),
@@ -60,4 +78,8 @@ glm::mat4 Translate::get_transform(const glm::mat4 &model) const {
     return glm::translate(model, direction);
 }
 
+size_t Translate::compile_transform(DrawList &list, size_t parent) const {
+    return list.add_translate(parent, glm::vec3(x, y, z), rz);
+}
+
 }
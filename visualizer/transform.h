@@ -11,11 +11,13 @@ public:
     explicit Transform(std::shared_ptr<Object> object);
 
     void draw(Batch &batch, const glm::mat4& model) const override;
+    void compile(DrawList &list, size_t parent) const override;
 
 private:
     std::shared_ptr<Object> object;
 
     virtual glm::mat4 get_transform(const glm::mat4& model) const = 0;
+    virtual size_t compile_transform(DrawList &list, size_t parent) const = 0;
 };
 
 class Scale : public Transform {
@@ -25,6 +27,7 @@ private:
     const float *factor;
 
     glm::mat4 get_transform(const glm::mat4& model) const override;
+    size_t compile_transform(DrawList &list, size_t parent) const override;
 };
 
 class Deform : public Transform {
@@ -35,6 +38,7 @@ private:
     const float *height;
 
     glm::mat4 get_transform(const glm::mat4& model) const override;
+    size_t compile_transform(DrawList &list, size_t parent) const override;
 };
 
 class Rotate : public Transform {
@@ -45,6 +49,7 @@ private:
     const float *degree;
 
     glm::mat4 get_transform(const glm::mat4& model) const override;
+    size_t compile_transform(DrawList &list, size_t parent) const override;
 };
 
 class Translate : public Transform {
@@ -59,6 +64,7 @@ private:
     const float *rz;
 
     glm::mat4 get_transform(const glm::mat4& model) const override;
+    size_t compile_transform(DrawList &list, size_t parent) const override;
 };
 
 }
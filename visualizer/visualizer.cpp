@@ -8,31 +8,51 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <array>
+#include <cfloat>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <optional>
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include <scene.vert.h>
 #include <scene.frag.h>
+#include <scene_instanced.vert.h>
 #include <screen.vert.h>
 #include <screen.frag.h>
 #include <blur.vert.h>
 #include <blur.frag.h>
 
+#include <analyzer.h>
 #include <audio.h>
+#include <buffer.h>
+#include <featurecache.h>
+#include <glstate.h>
+#include <mixer.h>
+#include <peakpyramid.h>
+#include <qoafile.h>
+#include <qoasource.h>
 #include <shader.h>
 #include <program.h>
+#include <programcache.h>
 #include <quad.h>
+#include <threadpool.h>
+#include <timerquery.h>
 #include <wave.h>
 
 #include "batch.h"
-#include "collection.h"
+#include "drawlist.h"
+#include "frame.h"
+#include "instancedbatch.h"
+#include "nodepool.h"
 #include "parameters.h"
-#include "ring.h"
 #include "scene.h"
-#include "shape.h"
-#include "transform.h"
+#include "waveform.h"
 #include "postprocessing.h"
 
 #ifdef _WIN32
@@ -62,19 +82,73 @@ void logger(GLenum source,
     std::cout << message << std::endl;
 }
 
-void play_buffer(const Wave &wav, size_t &offset, Uint64 &timestamp, Uint8* data, int len) {
-    if (offset >= wav.get_length()) {
-        return;
+// Builds a program from a vertex and a fragment shader with the given
+// attribute locations, or loads it from the cache if there's one. Building
+// is only submitted, and checked when the program is first used.
+void build_program(Program &program, ProgramCache *cache, const char *vertex_source, const char *fragment_source,
+                   const std::vector<std::pair<GLuint, const char *>> &attributes)
+{
+    Uint64 key = 0;
+    if (cache != nullptr) {
+        std::vector<std::string> parts{ vertex_source, fragment_source };
+        for (const auto &[index, name] : attributes) {
+            parts.push_back(std::to_string(index) + ' ' + name);
+        }
+        key = cache->get_key(parts);
+        if (cache->load(program, key)) {
+            return;
+        }
+        program.set_retrievable();
+    }
+    program.attach(Shader(GL_VERTEX_SHADER, vertex_source));
+    program.attach(Shader(GL_FRAGMENT_SHADER, fragment_source));
+    for (const auto &[index, name] : attributes) {
+        program.bind(index, name);
     }
-    const size_t remainder = wav.get_length() - offset;
-    int actual_len = len;
-    if (remainder < len) {
-        actual_len = static_cast<int>(remainder);
+    program.link();
+    if (cache != nullptr) {
+        cache->store(program, key);
+    }
+}
+
+void plot_histogram(const char *label, const AudioStatistics::Histogram &histogram) {
+    std::array<float, AudioStatistics::Histogram::NUM_BUCKETS> counts;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = static_cast<float>(histogram.get_count(i));
     }
-    memset(data, 0, len);
-    SDL_MixAudioFormat(data, wav.get_buffer() + offset, wav.get_spec().format, actual_len, SDL_MIX_MAXVOLUME);
-    offset += actual_len;
-    timestamp = SDL_GetTicks64();
+    ImGui::PlotHistogram(label, counts.data(), static_cast<int>(counts.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+}
+
+void plot_audio_statistics(const Audio &audio) {
+    const AudioStatistics &statistics = audio.get_statistics();
+    ImGui::Text("Buffer: %u samples (%.1f ms)", static_cast<unsigned int>(statistics.get_buffer_size()), statistics.get_buffer_duration());
+    ImGui::Text("Output latency: %.1f ms", audio.get_latency());
+    ImGui::Text("Callbacks: %u, late: %u, end of data: %u", statistics.get_callbacks(), statistics.get_late_callbacks(), statistics.get_end_of_data());
+    ImGui::Text("Max callback duration: %u us", statistics.get_max_duration());
+    plot_histogram("Callback (log2 us)", statistics.get_durations());
+    plot_histogram("Interval (log2 us)", statistics.get_intervals());
+}
+
+size_t get_measure_frame(float measure, float ms_per_measure, float offset, int freq) {
+    const double ms = static_cast<double>(offset) + static_cast<double>(measure) * ms_per_measure;
+    return ms > 0.0 ? static_cast<size_t>(std::llround(ms * freq / 1000.0)) : 0;
+}
+
+std::string get_stem_name(const std::string &filename) {
+    const std::string::size_type slash = filename.find_last_of("/\\");
+    const std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    return name.substr(0, name.find('.'));
+}
+
+bool is_qoa(const std::string &filename) {
+    return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".qoa") == 0;
+}
+
+std::unique_ptr<Mixer::Source> load_source(const std::string &filename, const SDL_AudioSpec &spec) {
+    if (is_qoa(filename)) {
+        return std::make_unique<QOASource>(std::make_shared<QOAFile>(filename), spec);
+    }
+    return std::make_unique<WaveSource>(Wave(filename), spec);
 }
 
 int main(int argc, char *argv[]) {
@@ -83,13 +157,6 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    size_t offset = 0;
-    Uint64 timestamp = 0;
-    Wave wav(argv[2]);
-    const SDL_AudioSpec spec = wav.get_spec();
-    Audio audio(spec);
-    audio.set_callback([&wav, &offset, &timestamp] (Uint8 *data, int len) { play_buffer(wav, offset, timestamp, data, len); });
-
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
     SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
@@ -98,7 +165,7 @@ int main(int argc, char *argv[]) {
     SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
     static const int width = 800;
@@ -128,48 +195,91 @@ int main(int argc, char *argv[]) {
     //glEnable(GL_DEBUG_OUTPUT);
     //glDebugMessageCallback(logger, nullptr);
 
-    Program scene_shader;
-    scene_shader.attach(Shader(GL_VERTEX_SHADER, scene_vertex_shader));
-    scene_shader.attach(Shader(GL_FRAGMENT_SHADER, scene_fragment_shader));
-    scene_shader.bind(visualizer::Batch::ATTRIBUTE_POSITION, "position");
-    scene_shader.bind(visualizer::Batch::ATTRIBUTE_COLOR, "color");
-    scene_shader.bind(visualizer::Batch::ATTRIBUTE_GLOW, "glow");
-    scene_shader.link();
-    {
-        auto usage = scene_shader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
-        usage.set_uniform("projection", projection);
-
-        glm::mat4 view = glm::mat4(1.0f);
-        view = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
-        usage.set_uniform("view", view);
-
-        glm::vec3 light{ 0.0f, 0.0f, 0.0f };
-        usage.set_uniform("light", light);
+    std::unique_ptr<ProgramCache> program_cache;
+    if (ProgramCache::is_supported()) {
+        if (char *path = SDL_GetPrefPath("visualizer", "programs")) {
+            program_cache = std::make_unique<ProgramCache>(path);
+            SDL_free(path);
+        }
     }
+    const Uint64 programs_start = SDL_GetPerformanceCounter();
 
-    Program screen_shader;
-    screen_shader.attach(Shader(GL_VERTEX_SHADER, screen_vertex_shader));
-    screen_shader.attach(Shader(GL_FRAGMENT_SHADER, screen_fragment_shader));
-    screen_shader.bind(Quad::ATTRIBUTE_POSITION, "position");
-    screen_shader.bind(Quad::ATTRIBUTE_TEXTURE_COORD, "texture_coord");
-    screen_shader.link();
-    {
-        auto usage = screen_shader.use();
+    Program scene_shader;
+    build_program(scene_shader, program_cache.get(), scene_vertex_shader, scene_fragment_shader, {
+        { visualizer::Batch::ATTRIBUTE_POSITION, "position" },
+        { visualizer::Batch::ATTRIBUTE_COLOR, "color" },
+        { visualizer::Batch::ATTRIBUTE_GLOW, "glow" }
+    });
+    Program scene_instanced_shader;
+    build_program(scene_instanced_shader, program_cache.get(), scene_instanced_vertex_shader, scene_fragment_shader, {
+        { visualizer::InstancedBatch::ATTRIBUTE_POSITION, "position" },
+        { visualizer::InstancedBatch::ATTRIBUTE_COLOR, "color" },
+        { visualizer::InstancedBatch::ATTRIBUTE_GLOW, "glow" },
+        { visualizer::InstancedBatch::ATTRIBUTE_MODEL, "model" }
+    });
+    const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
 
-        glm::mat2 projection = glm::mat2(
-            static_cast<float>(size) / width, 0.0f,
-            0.0f,                             static_cast<float>(size) / height
-        );
-        usage.set_uniform("projection", projection);
+    Program screen_shader;
+    build_program(screen_shader, program_cache.get(), screen_vertex_shader, screen_fragment_shader, {
+        { Quad::ATTRIBUTE_POSITION, "position" },
+        { Quad::ATTRIBUTE_TEXTURE_COORD, "texture_coord" }
+    });
+
+    // The blur passes are specialised by direction and radius, and fetched
+    // by the key of their variant.
+    std::map<std::string, Program> blur_shaders;
+    for (const Shader::Variant &variant : blur_fragment_shader_variants) {
+        build_program(blur_shaders[variant.key], program_cache.get(), blur_vertex_shader, variant.source, {
+            { Quad::ATTRIBUTE_POSITION, "position" },
+            { Quad::ATTRIBUTE_TEXTURE_COORD, "texture_coord" }
+        });
     }
+    const Uint64 programs_submitted = SDL_GetPerformanceCounter();
+
+    std::unique_ptr<Wave> wav;
+    std::shared_ptr<QOAFile> qoa;
+    if (is_qoa(argv[2])) {
+        qoa = std::make_shared<QOAFile>(argv[2]);
+    } else {
+        wav = std::make_unique<Wave>(argv[2]);
+    }
+    const SDL_AudioSpec spec = qoa ? qoa->get_spec() : wav->get_spec();
+    Mixer mixer(spec);
+    std::unique_ptr<PeakPyramid> peaks;
+    if (qoa) {
+        mixer.add_source(get_stem_name(argv[2]), std::make_unique<QOASource>(qoa, spec));
+        peaks = std::make_unique<PeakPyramid>(*qoa);
+    } else {
+        mixer.add_source(get_stem_name(argv[2]), std::make_unique<WaveSource>(*wav, spec));
+        peaks = std::make_unique<PeakPyramid>(*wav);
+    }
+    for (int i = 3; i < argc; ++i) {
+        mixer.add_source(get_stem_name(argv[i]), load_source(argv[i], spec));
+    }
+    Analyzer analyzer(spec);
+    std::vector<std::unique_ptr<Analyzer>> stem_analyzers;
+    if (mixer.get_num_sources() > 1) {
+        for (size_t i = 0; i < mixer.get_num_sources(); ++i) {
+            stem_analyzers.push_back(std::make_unique<Analyzer>(spec));
+            mixer.set_analyzer(i, stem_analyzers.back().get());
+        }
+    }
+    Audio audio(spec);
+    audio.set_callback([&mixer, &analyzer] (Uint8 *data, int len) {
+        const int written = mixer.mix(data, len);
+        analyzer.push(data, len);
+        return written;
+    });
 
-    Program blur_shader;
-    blur_shader.attach(Shader(GL_VERTEX_SHADER, blur_vertex_shader));
-    blur_shader.attach(Shader(GL_FRAGMENT_SHADER, blur_fragment_shader));
-    blur_shader.bind(Quad::ATTRIBUTE_POSITION, "position");
-    blur_shader.bind(Quad::ATTRIBUTE_TEXTURE_COORD, "texture_coord");
-    blur_shader.link();
+
+    visualizer::Frame frame{};
+    frame.projection = projection;
+    frame.view = view;
+    frame.light = glm::vec3(0.0f, 0.0f, 0.0f);
+    Buffer frame_buffer;
+    frame_buffer.data(sizeof(frame), nullptr, GL_DYNAMIC_DRAW);
+    frame_buffer.bind_base(GL_UNIFORM_BUFFER, visualizer::Frame::BINDING);
 
     visualizer::Scene scene(size, size);
 
@@ -183,45 +293,124 @@ int main(int argc, char *argv[]) {
     //glViewport(0, 0, width, height);
     visualizer::Parameters parameters(argv[1]);
     parameters.set_debug_output("parameters.csv");
-    float scale = 0.3f;
-    auto ring = std::make_shared<visualizer::Ring>(3, 1.0f, std::initializer_list<std::shared_ptr<visualizer::Object>>{
-        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Triangle>(glm::vec3(1.0f, 1.0f, 0.0f), parameters.get_parameter("ring.triangle.glow1")), parameters.get_parameter("ring.triangle.width"), parameters.get_parameter("ring.triangle.height")), scale), parameters.get_parameter("ring.triangle.angle")),
-        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Rectangle>(glm::vec3(1.0f, 0.0f, 0.0f), parameters.get_parameter("ring.rectangle.glow1")), parameters.get_parameter("ring.rectangle.width"), parameters.get_parameter("ring.rectangle.height")), scale), parameters.get_parameter("ring.rectangle.angle")),
-        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Triangle>(glm::vec3(1.0f, 1.0f, 0.0f), parameters.get_parameter("ring.triangle.glow2")), parameters.get_parameter("ring.triangle.width"), parameters.get_parameter("ring.triangle.height")), scale), parameters.get_parameter("ring.triangle.angle")),
-        std::make_shared<visualizer::Rotate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Deform>(std::make_shared<visualizer::Rectangle>(glm::vec3(1.0f, 0.0f, 0.0f), parameters.get_parameter("ring.rectangle.glow2")), parameters.get_parameter("ring.rectangle.width"), parameters.get_parameter("ring.rectangle.height")), scale), parameters.get_parameter("ring.rectangle.angle"))});
-    auto rotating_ring1 = std::make_shared<visualizer::Translate>(std::make_shared<visualizer::Rotate>(ring, parameters.get_parameter("ring1.angle")), 0.0f, 0.0f, parameters.get_parameter("ring1.z"));
-    auto rotating_ring2 = std::make_shared<visualizer::Translate>(std::make_shared<visualizer::Rotate>(ring, parameters.get_parameter("ring2.angle")), 0.0f, 0.0f, parameters.get_parameter("ring2.z"));
-    auto rotating_ring3 = std::make_shared<visualizer::Translate>(std::make_shared<visualizer::Rotate>(ring, parameters.get_parameter("ring3.angle")), 0.0f, 0.0f, parameters.get_parameter("ring3.z"));
-    auto collection = std::make_shared<visualizer::Collection>(std::initializer_list<std::shared_ptr<visualizer::Object>>{ rotating_ring1, rotating_ring2, rotating_ring3,
-        std::make_shared<visualizer::Translate>(std::make_shared<visualizer::Scale>(std::make_shared<visualizer::Circle>(glm::vec3(1.0f, 1.0f, 1.0f), parameters.get_parameter("tick")), 0.1f), glm::vec3(-1.9f, -1.4f, 0.0f)) });
+    for (int i = 0; i < FeatureExtractor::NUM_FEATURES; ++i) {
+        const auto feature = static_cast<FeatureExtractor::Feature>(i);
+        parameters.add_input(std::string("audio.") + FeatureExtractor::get_name(feature), analyzer.get_feature(feature));
+        for (size_t j = 0; j < stem_analyzers.size(); ++j) {
+            parameters.add_input("audio." + mixer.get_name(j) + '.' + FeatureExtractor::get_name(feature), stem_analyzers[j]->get_feature(feature));
+        }
+    }
+    std::unique_ptr<FeatureCache> features;
+    if (wav) {
+        try {
+            features = std::make_unique<FeatureCache>(FeatureCache::get_filename(argv[2]), wav->get_hash());
+            parameters.set_feature_cache(features.get());
+        } catch (const std::runtime_error &e) {
+            std::cerr << "No audio features: " << e.what() << '\n';
+        }
+    }
+    std::unique_ptr<visualizer::NodePool> scene_graph;
+    try {
+        scene_graph = std::make_unique<visualizer::NodePool>(argv[1], parameters);
+    } catch (const std::runtime_error &e) {
+        std::cerr << argv[1] << ": " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    visualizer::DrawList draw_list(*scene_graph);
+    draw_list.set_view(projection, view, size);
     visualizer::Batch batch;
+    visualizer::InstancedBatch instanced_batch;
 
     const glm::mat4 model{glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f))};
 
-    const float ms_per_measure = parameters.get_ms_per_measure();
-    const size_t sample_size = spec.channels * (SDL_AUDIO_BITSIZE(spec.format) >> 3);
-    const float ms_per_offset = 1000.0f / (spec.freq * sample_size);
-    const size_t alignment = std::numeric_limits<size_t>::max() << (sample_size >> 1);
-    // 0x0000 0x0001 0x0002 0x0003 0x0004 0x0005 0x0006 0x0007
-    // L      l      R      r      L      l      R      r
-    const ptrdiff_t rough_measure_offset = static_cast<ptrdiff_t>(ms_per_measure / ms_per_offset) & alignment;
+    const float ms_per_frame = 1000.0f / spec.freq;
+    const visualizer::Waveform waveform(*peaks);
+    const double ticks_per_ms = static_cast<double>(SDL_GetPerformanceFrequency()) / 1000.0;
+
+    // The programs are first used here, so the driver had all of the loading
+    // above to build them.
+    std::vector<const Program *> programs{ &scene_shader, &scene_instanced_shader, &screen_shader };
+    for (const auto &[key, program] : blur_shaders) {
+        programs.push_back(&program);
+    }
+    // Without GL_KHR_parallel_shader_compile, whether the programs are ready
+    // is unknown rather than assumed.
+    std::optional<size_t> num_ready = 0;
+    for (const Program *program : programs) {
+        const std::optional<bool> ready = program->is_ready();
+        if (!ready) {
+            num_ready.reset();
+            break;
+        }
+        *num_ready += *ready ? 1 : 0;
+    }
+    const Uint64 programs_used = SDL_GetPerformanceCounter();
+    {
+        auto usage = screen_shader.use();
+
+        glm::mat2 projection = glm::mat2(
+            static_cast<float>(size) / width, 0.0f,
+            0.0f,                             static_cast<float>(size) / height
+        );
+        usage.set_uniform("projection", projection);
+        usage.set_uniform("screen_texture", 0);
+        usage.set_uniform("glow_texture", 1);
+    }
+    for (const Program *program : programs) {
+        program->bind_uniform_block("Frame", visualizer::Frame::BINDING);
+    }
+    const Uint64 programs_ready = SDL_GetPerformanceCounter();
+    // Shown in the rendering window. Whether this was a cold or a warm start
+    // follows from the programs loaded from the cache.
+    const double programs_submit_ms = (programs_submitted - programs_start) / ticks_per_ms;
+    const double programs_wait_ms = (programs_ready - programs_used) / ticks_per_ms;
+    const size_t programs_cached = program_cache ? program_cache->get_num_loaded() : 0;
+    if (program_cache) {
+        try {
+            program_cache->flush();
+        } catch (const std::runtime_error &e) {
+            std::cerr << "Can't cache program: " << e.what() << '\n';
+        }
+    }
 
     float exposure = 1.0f;
     float gamma = 2.0f;
     Uint32 old_fps_ticks;
     Uint32 fps_ticks = SDL_GetTicks();
+    const Uint32 statistics_interval = 10000;
+    Uint32 statistics_ticks = fps_ticks;
     const int max_cool_down = 10;
     int cool_down = max_cool_down;
     bool quit = false;
     bool paused = false;
     bool debug = true;
+    bool instanced = true;
+    bool parallel = false;
+    int streaming = static_cast<int>(batch.get_streaming());
+    static const int blur_radii[] = { 4, 7 };
+    int blur_radius = 0;
+    // The blur passes of the chosen radius, looked up only when it changes.
+    const Program *vertical_blur = nullptr;
+    const Program *horizontal_blur = nullptr;
+    const auto choose_blur = [&] {
+        const std::string radius = std::to_string(blur_radii[blur_radius]);
+        vertical_blur = &blur_shaders.at("HORIZONTAL=0,RADIUS=" + radius);
+        horizontal_blur = &blur_shaders.at("HORIZONTAL=1,RADIUS=" + radius);
+    };
+    choose_blur();
+    GLState &gl_state = GLState::get();
+    bool tracking = gl_state.is_tracking();
+    size_t gl_calls = 0;
+    size_t gl_saved = 0;
+    ThreadPool pool;
+    TimerQuery scene_timer;
     audio.pause(false);
     float measure = 0.0f;
     while (!quit) {
         old_fps_ticks = fps_ticks;
         SDL_Event event;
 
-        ptrdiff_t offset_shift = 0;
+        int measure_shift = 0;
         while(SDL_PollEvent(&event)) {
             ImGui_ImplSDL2_ProcessEvent(&event);
             switch(event.type) {
@@ -234,10 +423,10 @@ int main(int argc, char *argv[]) {
                         quit = true;
                         break;
                     case SDLK_LEFT:
-                        offset_shift = -rough_measure_offset;
+                        measure_shift = -1;
                         break;
                     case SDLK_RIGHT:
-                        offset_shift = rough_measure_offset;
+                        measure_shift = 1;
                         break;
                     case SDLK_UP:
                         exposure += 0.1f;
@@ -260,19 +449,26 @@ int main(int argc, char *argv[]) {
                         }
                         break;
                     case SDLK_PAGEUP:
-                        offset_shift = -4 * rough_measure_offset;
+                        measure_shift = -4;
                         break;
                     case SDLK_PAGEDOWN:
-                        offset_shift = 4 * rough_measure_offset;
+                        measure_shift = 4;
                         break;
                     case SDLK_SPACE:
                         paused = !paused;
                         if (!paused) {
-                            timestamp = SDL_GetTicks64();
+                            mixer.seek(mixer.get_position());
                         }
                         break;
                     case SDLK_F5:
                         parameters.load(argv[1]);
+                        try {
+                            scene_graph->load(argv[1]);
+                            draw_list = visualizer::DrawList(*scene_graph);
+                            draw_list.set_view(projection, view, size);
+                        } catch (const std::runtime_error &e) {
+                            std::cerr << e.what() << '\n';
+                        }
                         break;
                     case SDLK_d:
                         debug = !debug;
@@ -282,17 +478,25 @@ int main(int argc, char *argv[]) {
             }
         }
         audio.pause(paused);
-        if (paused) {
-            timestamp = SDL_GetTicks64();
+        audio.adapt();
+        // The mixer plays its own copy of the song, so the decoded file is
+        // only kept until the peaks of the waveform are built from it.
+        if (wav && peaks->is_ready()) {
+            wav.reset();
         }
-        if (offset_shift != 0) {
-            const auto lock = audio.lock();
-            if (offset_shift < 0 && offset < static_cast<size_t>(-offset_shift)) {
-                offset = 0;
-            } else {
-                offset += offset_shift;
+        analyzer.set_output_latency(audio.get_latency());
+        for (const auto &stem_analyzer : stem_analyzers) {
+            stem_analyzer->set_output_latency(audio.get_latency());
+        }
+        if (measure_shift != 0) {
+            // Forward goes to the next boundaries, backward returns to the
+            // start of the current measure first unless that was just passed.
+            float current = std::floor(measure);
+            if (measure_shift < 0 && measure - current > 0.1f) {
+                current += 1.0f;
             }
-            timestamp = SDL_GetTicks64();
+            const float target = std::max(0.0f, current + static_cast<float>(measure_shift));
+            mixer.seek(get_measure_frame(target, parameters.get_ms_per_measure(), parameters.get_offset(), spec.freq), audio.get_latency());
         }
 
         {
@@ -301,22 +505,35 @@ int main(int argc, char *argv[]) {
             glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-            auto usage = scene_shader.use();
-            float t = 0.0f;
-            {
-                const auto lock = audio.lock();
-                t = static_cast<float>(offset) * ms_per_offset + (SDL_GetTicks64() - timestamp);
-            }
-            measure = t / ms_per_measure;
+            auto usage = (instanced ? scene_instanced_shader : scene_shader).use();
+            const Mixer::Playhead playhead = mixer.get_playhead();
+            const double elapsed = paused ? 0.0 : static_cast<double>(SDL_GetPerformanceCounter() - playhead.counter) / ticks_per_ms;
+            const float t = static_cast<float>(playhead.position) * ms_per_frame + static_cast<float>(elapsed) - audio.get_latency();
+            measure = (t - parameters.get_offset()) / parameters.get_ms_per_measure();
             parameters.set_measure(measure >= 0.0f ? measure : 0.0f);
-            batch.clear();
-            collection->draw(batch, model);
-            batch.draw();
+            frame.measure = measure;
+            frame.exposure = exposure;
+            frame.gamma = gamma;
+            frame_buffer.subdata(0, sizeof(frame), &frame);
+            scene_timer.begin();
+            if (instanced) {
+                instanced_batch.clear();
+                draw_list.draw(instanced_batch, model);
+                instanced_batch.draw();
+            } else {
+                batch.clear();
+                if (parallel) {
+                    draw_list.draw(batch, model, pool);
+                } else {
+                    draw_list.draw(batch, model);
+                }
+                batch.draw();
+            }
+            scene_timer.end();
         }
         glDisable(GL_DEPTH_TEST);
         {
-            auto usage = blur_shader.use();
-            usage.set_uniform("horizontal", false);
+            auto usage = vertical_blur->use();
             auto colors = scene.bind_glow_as_source(GL_TEXTURE0);
             auto target = postprocessing1.bind_as_target();
 
@@ -325,8 +542,7 @@ int main(int argc, char *argv[]) {
             quad.draw();
         }
         {
-            auto usage = blur_shader.use();
-            usage.set_uniform("horizontal", true);
+            auto usage = horizontal_blur->use();
             auto colors = postprocessing1.bind_as_source(GL_TEXTURE0);
             auto target = postprocessing2.bind_as_target();
 
@@ -336,8 +552,7 @@ int main(int argc, char *argv[]) {
         }
         for (int i = 0; i < 5; ++i) {
             {
-                auto usage = blur_shader.use();
-                usage.set_uniform("horizontal", false);
+                auto usage = vertical_blur->use();
                 auto colors = postprocessing2.bind_as_source(GL_TEXTURE0);
                 auto target = postprocessing1.bind_as_target();
 
@@ -346,8 +561,7 @@ int main(int argc, char *argv[]) {
                 quad.draw();
             }
             {
-                auto usage = blur_shader.use();
-                usage.set_uniform("horizontal", true);
+                auto usage = horizontal_blur->use();
                 auto colors = postprocessing1.bind_as_source(GL_TEXTURE0);
                 auto target = postprocessing2.bind_as_target();
 
@@ -357,19 +571,14 @@ int main(int argc, char *argv[]) {
             }
         }
         {
+            gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
             glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
             glViewport(0, 0, width, height);
             glClear(GL_COLOR_BUFFER_BIT);
 
             auto usage = screen_shader.use();
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, scene.get_color_buffer_id());
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, postprocessing2.get_texture_id());
-            usage.set_uniform("screen_texture", 0);
-            usage.set_uniform("glow_texture", 1);
-            usage.set_uniform("exposure", exposure);
-            usage.set_uniform("gamma", gamma);
+            gl_state.bind_texture(GL_TEXTURE0, GL_TEXTURE_2D, scene.get_color_buffer_id());
+            gl_state.bind_texture(GL_TEXTURE1, GL_TEXTURE_2D, postprocessing2.get_texture_id());
             //auto colors = scene.bind_colors_as_source(GL_TEXTURE0);
             //auto glow = postprocessing2.bind_as_source(GL_TEXTURE1);
 
@@ -391,12 +600,89 @@ int main(int argc, char *argv[]) {
                 ImPlot::DragLineX(1, &x, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
                 ImPlot::EndPlot();
             }
+            if (ImPlot::BeginPlot("##waveform", ImVec2(-1, 100), ImPlotFlags_NoFrame)) {
+                ImPlot::SetupAxis(ImAxis_Y1, nullptr, ImPlotAxisFlags_NoDecorations | ImPlotAxisFlags_Lock);
+                ImPlot::SetupAxisLimits(ImAxis_Y1, -1.0, 1.0, ImGuiCond_Always);
+                ImPlot::SetupAxisLimits(ImAxis_X1, measure - 4.0f, measure + 4.0f, ImGuiCond_Always);
+                ImPlot::SetupFinish();
+                waveform.plot(measure, 4.0f, static_cast<int>(ImPlot::GetPlotSize().x), parameters.get_ms_per_measure(), parameters.get_offset());
+                double x = measure;
+                ImPlot::DragLineX(1, &x, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+                ImPlot::EndPlot();
+            }
+            ImGui::Text("Audio analysis latency after playback: %.1f ms (max %.1f ms)", analyzer.get_latency(), analyzer.get_max_latency());
+            ImGui::End();
+
+            ImGui::Begin("Mixer");
+            for (size_t i = 0; i < mixer.get_num_sources(); ++i) {
+                const std::string &name = mixer.get_name(i);
+                bool muted = mixer.is_muted(i);
+                if (ImGui::Checkbox(("##mute" + name).c_str(), &muted)) {
+                    mixer.set_muted(i, muted);
+                }
+                ImGui::SameLine();
+                float gain = mixer.get_gain(i);
+                if (ImGui::SliderFloat(name.c_str(), &gain, 0.0f, 2.0f)) {
+                    mixer.set_gain(i, gain);
+                }
+            }
+            ImGui::End();
+
+            ImGui::Begin("Rendering");
+            ImGui::Checkbox("Instanced", &instanced);
+            ImGui::Text("Scene: %.3f ms on the GPU", scene_timer.get_elapsed() / 1000000.0);
+            if (ImGui::Combo("Blur radius", &blur_radius, "4\0" "7\0")) {
+                choose_blur();
+            }
+            if (ImGui::Checkbox("Track GL state", &tracking)) {
+                gl_state.set_tracking(tracking);
+            }
+            ImGui::Text("Binds: %zu per frame, %zu saved", gl_calls, gl_saved);
+            const std::string programs_ready_text = num_ready
+                ? std::to_string(*num_ready) + " of " + std::to_string(programs.size()) + " ready"
+                : "readiness unknown";
+            ImGui::Text("Programs: submitted in %.1f ms, %s after loading, %.1f ms waited for the rest",
+                        programs_submit_ms, programs_ready_text.c_str(), programs_wait_ms);
+            ImGui::Text("%zu programs loaded from the cache", programs_cached);
+            ImGui::Text("%zu scene nodes, %zu transforms, %zu shapes", scene_graph->get_num_nodes(), draw_list.get_num_transforms(), draw_list.get_num_shapes());
+            ImGui::Text("Cached: %.1f%% of matrices, %.1f%% of shapes", draw_list.get_transform_hit_rate() * 100.0f, draw_list.get_shape_hit_rate() * 100.0f);
+            ImGui::Text("Tessellated: %zu vertices, max. error %.2f pixels", draw_list.get_num_vertices(), draw_list.get_max_error());
+            if (instanced) {
+                ImGui::Text("%zu instances, %zu vertices", instanced_batch.get_num_instances(), instanced_batch.get_num_vertices());
+                const MeshRegistry &meshes = instanced_batch.get_meshes();
+                ImGui::Text("%zu static meshes, %zu vertices, %zu indices", meshes.get_num_meshes(), meshes.get_num_vertices(), meshes.get_num_indices());
+            } else {
+                ImGui::Checkbox("Parallel", &parallel);
+                ImGui::Text("%zu vertices, %zu indices, %zu bytes in %zu chunks", batch.get_num_vertices(), batch.get_num_indices(), batch.get_size(), batch.get_num_chunks());
+                ImGui::Text("%zu segments on %zu threads", draw_list.get_num_segments(), pool.get_num_threads());
+                if (ImGui::Combo("Streaming", &streaming, "Persistent\0Orphaned\0Synchronized\0")) {
+                    const auto mode = static_cast<StreamBuffer::Mode>(streaming);
+                    if (StreamBuffer::is_supported(mode)) {
+                        batch.set_streaming(mode);
+                    }
+                    streaming = static_cast<int>(batch.get_streaming());
+                }
+                ImGui::Text("Mapping: %.1f us", batch.get_map_time() / 1000.0);
+            }
+            ImGui::End();
+
+            ImGui::Begin("Audio");
+            plot_audio_statistics(audio);
             ImGui::End();
 
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            gl_state.invalidate();
         }
         SDL_GL_SwapWindow(window);
+        gl_calls = gl_state.get_num_calls();
+        gl_saved = gl_state.get_num_saved();
+        gl_state.reset_counts();
+
+        if (SDL_GetTicks() - statistics_ticks >= statistics_interval) {
+            statistics_ticks = SDL_GetTicks();
+            audio.get_statistics().dump(std::cout);
+        }
 
         if (cool_down == 0) {
             fps_ticks = SDL_GetTicks();
@@ -0,0 +1,79 @@
+#include "waveform.h"
+
+#include <peakpyramid.h>
+
+#include <implot.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace visualizer {
+
+Waveform::Waveform(const PeakPyramid &peaks)
+  : peaks(peaks) { }
+
+namespace {
+
+class Plotter {
+public:
+    Plotter(const std::vector<PeakPyramid::Peak> &peaks, float xmin, float xstep)
+      : peaks(peaks),
+        xmin(xmin),
+        xstep(xstep) { }
+
+    static ImPlotPoint min(int idx, void *data) {
+        const Plotter *self = static_cast<const Plotter *>(data);
+        return ImPlotPoint(self->get_x(idx), self->peaks[idx].min);
+    }
+
+    static ImPlotPoint max(int idx, void *data) {
+        const Plotter *self = static_cast<const Plotter *>(data);
+        return ImPlotPoint(self->get_x(idx), self->peaks[idx].max);
+    }
+
+    static ImPlotPoint rms_low(int idx, void *data) {
+        const Plotter *self = static_cast<const Plotter *>(data);
+        return ImPlotPoint(self->get_x(idx), -std::sqrt(self->peaks[idx].power));
+    }
+
+    static ImPlotPoint rms_high(int idx, void *data) {
+        const Plotter *self = static_cast<const Plotter *>(data);
+        return ImPlotPoint(self->get_x(idx), std::sqrt(self->peaks[idx].power));
+    }
+
+private:
+    const std::vector<PeakPyramid::Peak> &peaks;
+    float xmin;
+    float xstep;
+
+    double get_x(int idx) const {
+        return xmin + (static_cast<float>(idx) + 0.5f) * xstep;
+    }
+};
+
+}
+
+void Waveform::plot(float measure, float around, int count, float ms_per_measure, float offset) const {
+    if (!peaks.is_ready() || count <= 0) {
+        return;
+    }
+    const float frames_per_ms = static_cast<float>(peaks.get_frequency()) / 1000.0f;
+    const float frames_per_measure = ms_per_measure * frames_per_ms;
+    const float first_frame = offset * frames_per_ms;
+
+    const float xmin = measure - around;
+    const float xstep = 2.0f * around / static_cast<float>(count);
+    std::vector<PeakPyramid::Peak> columns(count);
+    for (int i = 0; i < count; ++i) {
+        const float begin = first_frame + (xmin + static_cast<float>(i) * xstep) * frames_per_measure;
+        const float end = begin + xstep * frames_per_measure;
+        columns[i] = peaks.get_peak(static_cast<size_t>(std::max(begin, 0.0f)), static_cast<size_t>(std::max(end, 0.0f)));
+    }
+
+    Plotter plotter(columns, xmin, xstep);
+    ImPlot::PlotShadedG("peak", &Plotter::min, &plotter, &Plotter::max, &plotter, count);
+    ImPlot::PlotShadedG("rms", &Plotter::rms_low, &plotter, &Plotter::rms_high, &plotter, count);
+}
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+class PeakPyramid;
+
+namespace visualizer {
+
+class Waveform {
+public:
+    explicit Waveform(const PeakPyramid &peaks);
+
+    // The measures are passed in rather than kept, so that the grid follows
+    // the tempo and offset when the parameters are reloaded.
+    void plot(float measure, float around, int count, float ms_per_measure, float offset) const;
+
+private:
+    const PeakPyramid &peaks;
+};
+
+}